@@ -1,10 +1,24 @@
 
 QT += testlib  # Добавьте это для тестов
 QT += widgets  # Для GUI-приложения
-QT += core gui widgets
+QT += core gui widgets concurrent
 TARGET = EmotionDetection
 SOURCES += \
     main.cpp \
-    emotiondetector.cpp
+    analysisscheduler.cpp \
+    baselinestore.cpp \
+    documentanalyzer.cpp \
+    emotiondetector.cpp \
+    emotiontimeline.cpp \
+    emotiontracker.cpp \
+    utf8lexicon.cpp \
+    wordscanner.cpp
 HEADERS += \
-    emotiondetector.h
+    analysisscheduler.h \
+    baselinestore.h \
+    documentanalyzer.h \
+    emotiondetector.h \
+    emotiontimeline.h \
+    emotiontracker.h \
+    utf8lexicon.h \
+    wordscanner.h
@@ -0,0 +1,34 @@
+TEMPLATE = app
+TARGET = EmotionDetectionFuzz
+QT += core concurrent
+
+SOURCES += fuzzdetector.cpp \
+           analysisscheduler.cpp \
+           baselinestore.cpp \
+           differentialcheck.cpp \
+           documentanalyzer.cpp \
+           emotiondetector.cpp \
+           emotiontracker.cpp \
+           referencedetector.cpp \
+           utf8lexicon.cpp \
+           wordscanner.cpp
+
+HEADERS += analysisscheduler.h \
+           baselinestore.h \
+           differentialcheck.h \
+           documentanalyzer.h \
+           emotiondetector.h \
+           emotiontracker.h \
+           referencedetector.h \
+           utf8lexicon.h \
+           wordscanner.h
+
+# qmake CONFIG+=libfuzzer — сборка под libFuzzer с санитайзерами (clang)
+libfuzzer {
+    DEFINES += EMOTION_LIBFUZZER
+    QMAKE_CXXFLAGS += -fsanitize=fuzzer,address,undefined
+    QMAKE_LFLAGS += -fsanitize=fuzzer,address,undefined
+}
+
+CONFIG += console
+CONFIG -= app_bundle
@@ -1,11 +1,33 @@
 TEMPLATE = app
 TARGET = EmotionDetectionTests
-QT += testlib core
+QT += testlib core concurrent
 
 SOURCES += testemotiondetector.cpp \
-           emotiondetector.cpp
+           allocationcounter.cpp \
+           analysisscheduler.cpp \
+           baselinestore.cpp \
+           differentialcheck.cpp \
+           documentanalyzer.cpp \
+           emotiondetector.cpp \
+           emotiontimeline.cpp \
+           emotiontracker.cpp \
+           referencedetector.cpp \
+           syntheticcorpus.cpp \
+           utf8lexicon.cpp \
+           wordscanner.cpp
 
-HEADERS += emotiondetector.h \
+HEADERS += allocationcounter.h \
+           analysisscheduler.h \
+           baselinestore.h \
+           differentialcheck.h \
+           documentanalyzer.h \
+           emotiondetector.h \
+           emotiontimeline.h \
+           emotiontracker.h \
+           referencedetector.h \
+           syntheticcorpus.h \
+           utf8lexicon.h \
+           wordscanner.h \
            testemotiondetector.h
 
 CONFIG += console
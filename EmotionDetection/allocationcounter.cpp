@@ -0,0 +1,74 @@
+#include "allocationcounter.h"
+#include <cstddef>
+#include <cstdlib>
+
+#if defined(__has_feature)
+#  if __has_feature(address_sanitizer) || __has_feature(memory_sanitizer) || __has_feature(thread_sanitizer)
+#    define ALLOCATION_COUNTER_SANITIZED
+#  endif
+#endif
+#if defined(__SANITIZE_ADDRESS__) || defined(__SANITIZE_THREAD__)
+#  define ALLOCATION_COUNTER_SANITIZED
+#endif
+
+#if defined(__GLIBC__) && !defined(ALLOCATION_COUNTER_SANITIZED)
+
+namespace {
+thread_local quint64 allocations = 0;
+}
+
+// glibc разрешает заменить malloc в программе; настоящие функции
+// доступны под именами __libc_*
+extern "C" {
+void *__libc_malloc(std::size_t size);
+void *__libc_calloc(std::size_t count, std::size_t size);
+void *__libc_realloc(void *pointer, std::size_t size);
+void __libc_free(void *pointer);
+
+void *malloc(std::size_t size) noexcept
+{
+    ++allocations;
+    return __libc_malloc(size);
+}
+
+void *calloc(std::size_t count, std::size_t size) noexcept
+{
+    ++allocations;
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, std::size_t size) noexcept
+{
+    ++allocations;
+    return __libc_realloc(pointer, size);
+}
+
+void free(void *pointer) noexcept
+{
+    __libc_free(pointer);
+}
+}
+
+bool AllocationCounter::isAvailable()
+{
+    return true;
+}
+
+quint64 AllocationCounter::threadCount()
+{
+    return allocations;
+}
+
+#else
+
+bool AllocationCounter::isAvailable()
+{
+    return false;
+}
+
+quint64 AllocationCounter::threadCount()
+{
+    return 0;
+}
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef ALLOCATIONCOUNTER_H
+#define ALLOCATIONCOUNTER_H
+
+#include <QtGlobal>
+
+// Счётчик выделений памяти в текущем потоке. Работает там, где можно
+// подменить malloc (glibc без санитайзеров), и учитывает в том числе
+// буферы QString и QList.
+class AllocationCounter
+{
+public:
+    static bool isAvailable();
+    static quint64 threadCount();
+};
+
+#endif // ALLOCATIONCOUNTER_H
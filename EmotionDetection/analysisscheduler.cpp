@@ -0,0 +1,129 @@
+#include "analysisscheduler.h"
+#include <QCoreApplication>
+#include <QFutureWatcher>
+
+namespace {
+
+// Приоритеты в очереди пула: интерактивная задача встаёт впереди фоновых
+const int InteractivePoolPriority = 1;
+const int BulkPoolPriority = 0;
+
+}
+
+AnalysisScheduler::AnalysisScheduler(int threads)
+    : slots(qMax(1, threads - 1)), queue(std::make_shared<BulkQueue>())
+{
+    pool.setMaxThreadCount(slots + 1);
+}
+
+AnalysisScheduler::~AnalysisScheduler()
+{
+    std::map<quint64, Job> queued;
+    {
+        QMutexLocker locker(&queue->mutex);
+        stopping = true;
+        queued.swap(queue->jobs);
+    }
+    for (const auto &[id, job] : queued)
+        cancel(job);
+    // Задачи, ещё не взятые пулом, удаляются вместе с обещаниями,
+    // а QPromise при удалении отменяет свой QFuture
+    pool.clear();
+    pool.waitForDone();
+}
+
+QFuture<EmotionDetector::Emotion> AnalysisScheduler::submit(EmotionDetector::Priority priority, std::function<EmotionDetector::Emotion()> work)
+{
+    Job job{std::make_shared<QPromise<EmotionDetector::Emotion>>(), std::move(work)};
+    QFuture<EmotionDetector::Emotion> future = job.promise->future();
+
+    if (priority == EmotionDetector::Interactive) {
+        pool.start([job] { execute(job); }, InteractivePoolPriority);
+        return future;
+    }
+
+    quint64 id = 0;
+    {
+        QMutexLocker locker(&queue->mutex);
+        if (stopping) {
+            cancel(job);
+            return future;
+        }
+        id = queue->nextId++;
+        queue->jobs.emplace(id, std::move(job));
+        dispatchBulk();
+    }
+    watchCancel(future, id);
+    return future;
+}
+
+qsizetype AnalysisScheduler::queuedBulk() const
+{
+    QMutexLocker locker(&queue->mutex);
+    return qsizetype(queue->jobs.size());
+}
+
+void AnalysisScheduler::dispatchBulk()
+{
+    while (!stopping && runningBulk < slots && !queue->jobs.empty()) {
+        const auto head = queue->jobs.begin();
+        const Job job = head->second;
+        queue->jobs.erase(head);
+        // Отменённая в очереди задача не занимает поток
+        if (job.promise->isCanceled()) {
+            cancel(job);
+            continue;
+        }
+        ++runningBulk;
+        pool.start([this, job] {
+            execute(job);
+            QMutexLocker locker(&queue->mutex);
+            --runningBulk;
+            dispatchBulk();
+        }, BulkPoolPriority);
+    }
+}
+
+void AnalysisScheduler::watchCancel(const QFuture<EmotionDetector::Emotion> &future, quint64 id) const
+{
+    // Сигналы наблюдателя приходят через цикл событий потока, который
+    // поставил задачу; без цикла наблюдатель не сработал бы и не удалился
+    QThread *thread = QThread::currentThread();
+    const QCoreApplication *application = QCoreApplication::instance();
+    if (thread->loopLevel() == 0 && (!application || application->thread() != thread))
+        return;
+
+    // Отменённая задача сразу убирается из очереди по номеру и завершается,
+    // не дожидаясь задач перед ней
+    auto *watcher = new QFutureWatcher<EmotionDetector::Emotion>();
+    QObject::connect(watcher, &QFutureWatcherBase::finished, watcher, &QObject::deleteLater);
+    QObject::connect(watcher, &QFutureWatcherBase::canceled, watcher, [shared = std::weak_ptr<BulkQueue>(queue), id] {
+        const std::shared_ptr<BulkQueue> queue = shared.lock();
+        if (!queue)
+            return;
+        QMutexLocker locker(&queue->mutex);
+        const auto it = queue->jobs.find(id);
+        // Задача уже выполняется или завершена
+        if (it == queue->jobs.end())
+            return;
+        const Job job = it->second;
+        queue->jobs.erase(it);
+        cancel(job);
+    });
+    watcher->setFuture(future);
+}
+
+void AnalysisScheduler::execute(const Job &job)
+{
+    job.promise->start();
+    if (!job.promise->isCanceled())
+        job.promise->addResult(job.work());
+    job.promise->finish();
+}
+
+void AnalysisScheduler::cancel(const Job &job)
+{
+    job.promise->start();
+    job.promise->future().cancel();
+    job.promise->finish();
+}
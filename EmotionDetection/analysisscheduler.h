@@ -0,0 +1,69 @@
+#ifndef ANALYSISSCHEDULER_H
+#define ANALYSISSCHEDULER_H
+
+#include <QFuture>
+#include <QMutex>
+#include <QPromise>
+#include <QThread>
+#include <QThreadPool>
+#include <functional>
+#include <map>
+#include <memory>
+#include "emotiondetector.h"
+
+// Пул потоков детектора с двумя классами задач. Фоновые (Bulk) ждут в своей
+// очереди и занимают не больше bulkSlots() потоков, поэтому один поток
+// всегда свободен для интерактивных: те не ждут ни очереди, ни окончания
+// фоновой задачи. Фоновую задачу, ещё не начатую, можно отменить через
+// QFuture::cancel. Если у потока, поставившего её, есть цикл событий, она
+// сразу убирается из очереди и завершается; иначе — когда до неё дойдёт
+// очередь, поток она при этом не занимает.
+class AnalysisScheduler
+{
+public:
+    explicit AnalysisScheduler(int threads = QThread::idealThreadCount());
+    // Отменяет задачи в очереди и ждёт выполняющиеся
+    ~AnalysisScheduler();
+    AnalysisScheduler(const AnalysisScheduler &) = delete;
+    AnalysisScheduler &operator=(const AnalysisScheduler &) = delete;
+
+    QFuture<EmotionDetector::Emotion> submit(EmotionDetector::Priority priority, std::function<EmotionDetector::Emotion()> work);
+
+    int bulkSlots() const { return slots; }
+    // Фоновые задачи, которые ждут потока, включая отменённые, но ещё
+    // не убранные из очереди
+    qsizetype queuedBulk() const;
+
+private:
+    struct Job
+    {
+        std::shared_ptr<QPromise<EmotionDetector::Emotion>> promise;
+        std::function<EmotionDetector::Emotion()> work;
+    };
+
+    // Очередь разделяется с наблюдателями отмены: они могут сработать
+    // уже после удаления планировщика
+    struct BulkQueue
+    {
+        QMutex mutex;
+        // По номеру постановки, то есть в порядке очереди
+        std::map<quint64, Job> jobs;
+        quint64 nextId = 0;
+    };
+
+    QThreadPool pool;
+    const int slots;
+
+    std::shared_ptr<BulkQueue> queue;
+    // Защищены queue->mutex
+    int runningBulk = 0;
+    bool stopping = false;
+
+    void watchCancel(const QFuture<EmotionDetector::Emotion> &future, quint64 id) const;
+    // Вызывается под queue->mutex
+    void dispatchBulk();
+    static void execute(const Job &job);
+    static void cancel(const Job &job);
+};
+
+#endif // ANALYSISSCHEDULER_H
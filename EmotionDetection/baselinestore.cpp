@@ -0,0 +1,247 @@
+#include "baselinestore.h"
+#include <QSaveFile>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+const quint32 SnapshotMagic = 0x53424445; // "EDBS"
+const quint32 SnapshotVersion = 1;
+const qsizetype InitialCapacity = 64;
+
+// Норма, под которую подобраны пороги analyzeParameters
+const double ReferenceHeartRate = 72;
+const double ReferenceHeartRateDeviation = 6;
+const double ReferenceGsr = 6;
+const double ReferenceGsrDeviation = 1.5;
+// Слишком ровные показания не должны раздувать отклонения
+const double MinHeartRateDeviation = 3;
+const double MinGsrDeviation = 0.75;
+
+quint64 mix(quint64 key)
+{
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+}
+
+void addSample(float &mean, float &variance, double value, quint32 weight)
+{
+    // Формула Уэлфорда в виде обновления дисперсии; при ограниченном весе
+    // это экспоненциальное сглаживание
+    const double delta = value - mean;
+    const double newMean = mean + delta / weight;
+    variance = float(variance + (delta * (value - newMean) - variance) / weight);
+    mean = float(newMean);
+}
+
+double rescale(double value, double mean, double deviation, double reference, double referenceDeviation, double minDeviation)
+{
+    return reference + (value - mean) * referenceDeviation / qMax(deviation, minDeviation);
+}
+
+}
+
+BaselineStore::BaselineStore()
+{
+}
+
+BaselineStore::~BaselineStore()
+{
+    release();
+}
+
+void BaselineStore::update(quint64 userId, const QVector<double> &meters)
+{
+    if (meters.size() < 3 || !std::isfinite(meters[0]) || !std::isfinite(meters[1]))
+        return;
+
+    Slot &slot = findOrInsert(userId);
+    const quint32 weight = qMin(slot.count + 1, MaxWeight);
+    addSample(slot.heartRateMean, slot.heartRateVariance, meters[0], weight);
+    addSample(slot.gsrMean, slot.gsrVariance, meters[1], weight);
+    if (slot.count < std::numeric_limits<quint32>::max())
+        ++slot.count;
+}
+
+BaselineStore::Baseline BaselineStore::baseline(quint64 userId) const
+{
+    Baseline result;
+    if (const Slot *slot = find(userId)) {
+        result.count = slot->count;
+        result.heartRateMean = slot->heartRateMean;
+        result.heartRateDeviation = std::sqrt(qMax(0.0f, slot->heartRateVariance));
+        result.gsrMean = slot->gsrMean;
+        result.gsrDeviation = std::sqrt(qMax(0.0f, slot->gsrVariance));
+    }
+    return result;
+}
+
+QVector<double> BaselineStore::normalize(quint64 userId, const QVector<double> &meters) const
+{
+    const Baseline base = baseline(userId);
+    if (meters.size() < 3 || base.count < MinSamples)
+        return meters;
+
+    QVector<double> result = meters;
+    result[0] = rescale(meters[0], base.heartRateMean, base.heartRateDeviation,
+                        ReferenceHeartRate, ReferenceHeartRateDeviation, MinHeartRateDeviation);
+    result[1] = rescale(meters[1], base.gsrMean, base.gsrDeviation,
+                        ReferenceGsr, ReferenceGsrDeviation, MinGsrDeviation);
+    return result;
+}
+
+EmotionDetector::Emotion BaselineStore::classify(const EmotionDetector &detector, quint64 userId, const QVector<double> &meters) const
+{
+    return detector.analyzeParameters(normalize(userId, meters));
+}
+
+qsizetype BaselineStore::memoryUsage() const
+{
+    // Отображённый снимок подгружается по страницам и учитывается как есть
+    return qsizetype(sizeof(BaselineStore)) + capacity * qsizetype(sizeof(Slot));
+}
+
+void BaselineStore::clear()
+{
+    release();
+    count = 0;
+}
+
+QString BaselineStore::save(const QString &filename) const
+{
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly))
+        return file.errorString();
+
+    Header header = {};
+    header.magic = SnapshotMagic;
+    header.version = SnapshotVersion;
+    header.capacity = quint64(capacity);
+    header.size = quint64(count);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    if (capacity > 0)
+        file.write(reinterpret_cast<const char *>(slots), capacity * qsizetype(sizeof(Slot)));
+
+    if (!file.commit())
+        return file.errorString();
+    return QString();
+}
+
+QString BaselineStore::load(const QString &filename)
+{
+    auto file = std::make_unique<QFile>(filename);
+    if (!file->open(QIODevice::ReadOnly))
+        return file->errorString();
+
+    const qint64 fileSize = file->size();
+    if (fileSize < qint64(sizeof(Header)))
+        return QString("Файл %1 не является снимком норм").arg(filename);
+
+    // Копия при записи: обновления меняют только память процесса, не файл
+    uchar *data = file->map(0, fileSize, QFileDevice::MapPrivateOption);
+    if (!data)
+        return file->errorString();
+
+    const QString corrupt = QString("Файл %1 не является снимком норм или повреждён").arg(filename);
+    Header header;
+    std::memcpy(&header, data, sizeof(header));
+    // Проверяется только заголовок, таблица не читается: при size не больше
+    // 3/4 ёмкости в целой таблице всегда есть свободная ячейка, а на
+    // испорченной поиск ограничен ёмкостью (см. find и findOrInsert).
+    // Ёмкость сверяется делением: произведение на размер ячейки может переполниться
+    const quint64 fileSlots = (quint64(fileSize) - sizeof(Header)) / sizeof(Slot);
+    const bool powerOfTwo = header.capacity > 0 && (header.capacity & (header.capacity - 1)) == 0;
+    if (header.magic != SnapshotMagic || header.version != SnapshotVersion || !powerOfTwo
+        || header.capacity != fileSlots || (quint64(fileSize) - sizeof(Header)) % sizeof(Slot) != 0
+        || header.size > header.capacity * 3 / 4) {
+        return corrupt;
+    }
+
+    release();
+    mapped = std::move(file);
+    slots = reinterpret_cast<Slot *>(data + sizeof(Header));
+    capacity = qsizetype(header.capacity);
+    count = qsizetype(header.size);
+    return QString();
+}
+
+const BaselineStore::Slot *BaselineStore::find(quint64 userId) const
+{
+    if (capacity == 0)
+        return nullptr;
+
+    const quint64 key = userId + 1;
+    const qsizetype mask = capacity - 1;
+    qsizetype i = qsizetype(mix(key)) & mask;
+    for (qsizetype step = 0; step < capacity; ++step, i = (i + 1) & mask) {
+        if (slots[i].key == key)
+            return &slots[i];
+        if (slots[i].key == 0)
+            return nullptr;
+    }
+    return nullptr;
+}
+
+BaselineStore::Slot &BaselineStore::findOrInsert(quint64 userId)
+{
+    // Заполнение не выше 3/4: линейное пробирование остаётся коротким
+    if ((count + 1) * 4 > capacity * 3)
+        rehash(qMax(InitialCapacity, capacity * 2));
+
+    const quint64 key = userId + 1;
+    for (;;) {
+        const qsizetype mask = capacity - 1;
+        qsizetype i = qsizetype(mix(key)) & mask;
+        for (qsizetype step = 0; step < capacity; ++step, i = (i + 1) & mask) {
+            if (slots[i].key == key)
+                return slots[i];
+            if (slots[i].key == 0) {
+                std::memset(&slots[i], 0, sizeof(Slot));
+                slots[i].key = key;
+                ++count;
+                return slots[i];
+            }
+        }
+        // Свободной ячейки нет только в испорченном снимке, где size меньше
+        // числа записей; перестройка пересчитывает count
+        rehash(capacity * 2);
+    }
+}
+
+void BaselineStore::rehash(qsizetype newCapacity)
+{
+    QList<Slot> table(newCapacity);
+    const qsizetype mask = newCapacity - 1;
+    qsizetype copied = 0;
+    for (qsizetype i = 0; i < capacity; ++i) {
+        if (slots[i].key == 0)
+            continue;
+        qsizetype j = qsizetype(mix(slots[i].key)) & mask;
+        while (table[j].key != 0)
+            j = (j + 1) & mask;
+        table[j] = slots[i];
+        ++copied;
+    }
+
+    release();
+    owned = std::move(table);
+    slots = owned.data();
+    capacity = newCapacity;
+    count = copied;
+}
+
+void BaselineStore::release()
+{
+    if (mapped) {
+        mapped->unmap(reinterpret_cast<uchar *>(slots) - sizeof(Header));
+        mapped.reset();
+    }
+    owned = QList<Slot>();
+    slots = nullptr;
+    capacity = 0;
+}
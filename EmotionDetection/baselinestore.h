@@ -0,0 +1,90 @@
+#ifndef BASELINESTORE_H
+#define BASELINESTORE_H
+
+#include <QFile>
+#include <QList>
+#include <QString>
+#include <QVector>
+#include <memory>
+#include "emotiondetector.h"
+
+// Индивидуальная норма пульса и GSR для каждого пользователя: скользящее
+// среднее и дисперсия по каждому каналу. Таблица с открытой адресацией,
+// одна запись занимает 32 байта. Снимок записывается в файл как есть и
+// при загрузке отображается в память, поэтому перезапуск не читает файл целиком.
+class BaselineStore
+{
+public:
+    struct Baseline
+    {
+        quint32 count = 0;
+        double heartRateMean = 0;
+        double heartRateDeviation = 0;
+        double gsrMean = 0;
+        double gsrDeviation = 0;
+    };
+
+    // Сколько показаний нужно, прежде чем норма начнёт учитываться
+    static constexpr quint32 MinSamples = 30;
+    // После стольких показаний норма становится экспоненциальным средним
+    // и медленно следует за изменениями
+    static constexpr quint32 MaxWeight = 1000;
+
+    BaselineStore();
+    ~BaselineStore();
+    BaselineStore(const BaselineStore &) = delete;
+    BaselineStore &operator=(const BaselineStore &) = delete;
+
+    // Показания в формате analyzeParameters: пульс, GSR, температура
+    void update(quint64 userId, const QVector<double> &meters);
+    Baseline baseline(quint64 userId) const;
+
+    // Переводит показания к норме "среднего" человека, для которого
+    // подобраны пороги analyzeParameters
+    QVector<double> normalize(quint64 userId, const QVector<double> &meters) const;
+    EmotionDetector::Emotion classify(const EmotionDetector &detector, quint64 userId, const QVector<double> &meters) const;
+
+    qsizetype size() const { return count; }
+    qsizetype memoryUsage() const;
+    void clear();
+
+    // Возвращают текст ошибки или пустую строку
+    QString save(const QString &filename) const;
+    QString load(const QString &filename);
+
+private:
+    struct Slot
+    {
+        quint64 key;   // номер пользователя + 1, 0 — свободная ячейка
+        quint32 count;
+        float heartRateMean;
+        float heartRateVariance;
+        float gsrMean;
+        float gsrVariance;
+        quint32 reserved;
+    };
+    static_assert(sizeof(Slot) == 32, "запись должна занимать 32 байта");
+
+    struct Header
+    {
+        quint32 magic;
+        quint32 version;
+        quint64 capacity;
+        quint64 size;
+        quint64 reserved;
+    };
+
+    // Ячейки либо в owned, либо в отображённом файле снимка
+    Slot *slots = nullptr;
+    qsizetype capacity = 0;
+    qsizetype count = 0;
+    QList<Slot> owned;
+    std::unique_ptr<QFile> mapped;
+
+    const Slot *find(quint64 userId) const;
+    Slot &findOrInsert(quint64 userId);
+    void rehash(qsizetype newCapacity);
+    void release();
+};
+
+#endif // BASELINESTORE_H
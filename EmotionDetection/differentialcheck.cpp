@@ -0,0 +1,245 @@
+#include "differentialcheck.h"
+#include "baselinestore.h"
+#include "documentanalyzer.h"
+#include "referencedetector.h"
+#include "utf8lexicon.h"
+#include <QTemporaryFile>
+#include <cstring>
+#include <iterator>
+#include <limits>
+
+namespace {
+
+// Слова, которые задевают правила разбора: регистр, части слов,
+// отрицания, усилители, апострофы, не-ASCII и неверный UTF-8
+const char *const Words[] = {
+    "happy", "HAPPY", "Happy", "joy", "love", "excited", "wonderful", "sad", "lonely", "angry", "hate",
+    "not", "NOT", "never", "no", "cannot", "don't", "isn\xE2\x80\x99t", "very", "so", "really", "extremely",
+    "couldn\xE2\x80\x99t", "SHOULDN\xE2\x80\x99T", "wouldn't", "xxxxxxxxxxxxxxxxxxxxn\xE2\x80\x99t",
+    "crusade", "hateful", "unhappy", "lovely", "sadness", "the", "day", "x", "1",
+    "\xD0\xA0\xD0\xB0\xD0\xB4\xD0\xBE\xD1\x81\xD1\x82\xD1\x8C",  // Радость
+    "\xC4\xB0",                                                  // İ: в нижнем регистре два символа
+    "\xCC\x87",                                                  // диакритика без буквы
+    "\xE2\x84\xAA",                                              // знак кельвина, в нижнем регистре k
+    "\xEF\xBC\xA8\xEF\xBC\xA1\xEF\xBC\xB0\xEF\xBC\xB0\xEF\xBC\xB9", // полноширинное HAPPY
+    "\xF0\x9F\x98\x80", "\xF0\x90\x90\x80",                      // эмодзи и буква вне BMP
+    "\xE2\x80\x8D", "\xEF\xBB\xBF",                              // ZWJ и BOM
+    "\xFF", "\xC3", "\xE2\x82", "\xED\xA0\x80", "\xC0\xAF", "\xF4\x90\x80\x80"
+};
+
+const char *const Separators[] = {
+    " ", " ", " ", "", "  ", "'", "\xE2\x80\x99", "''", ".", ",", "!", "?", ";", "-", "\n", "\t",
+    "\xC2\xA0", "\xE3\x80\x82"
+};
+
+double randomMeter(QRandomGenerator &random)
+{
+    static const double Special[] = {
+        std::numeric_limits<double>::quiet_NaN(), std::numeric_limits<double>::infinity(),
+        -std::numeric_limits<double>::infinity(), -0.0, std::numeric_limits<double>::denorm_min(),
+        std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest(),
+        85, 8, 80, 7, 65, 5, 90, 10
+    };
+    switch (random.bounded(4)) {
+    case 0:
+        return Special[random.bounded(int(std::size(Special)))];
+    case 1:
+        return 50 + 70 * random.generateDouble();
+    case 2:
+        return 1 + 13 * random.generateDouble();
+    default:
+        return 35 + 3 * random.generateDouble();
+    }
+}
+
+QString emotionName(EmotionDetector::Emotion emotion)
+{
+    return EmotionDetector::emotionToString(emotion);
+}
+
+void compare(QStringList &mismatches, const QString &path, EmotionDetector::Emotion actual, EmotionDetector::Emotion expected)
+{
+    if (actual != expected)
+        mismatches.append(QString("%1: %2 вместо %3").arg(path, emotionName(actual), emotionName(expected)));
+}
+
+}
+
+DifferentialCheck::DifferentialCheck(const EmotionDetector &detector)
+    : detector(detector), tracker(&detector)
+{
+    tracker.setMinimumDwell(0);
+    for (int emotion = EmotionDetector::Neutral; emotion <= EmotionDetector::Surprise; ++emotion)
+        tracker.setHysteresis(EmotionDetector::Emotion(emotion), 0, 0);
+}
+
+QStringList DifferentialCheck::run(QByteArrayView input)
+{
+    const quint8 flags = input.isEmpty() ? 0 : quint8(input.front());
+    qsizetype at = 1;
+    const int count = (flags >> 1) & MaxMeters;
+    QVector<double> meters;
+    for (int i = 0; i < count && at + qsizetype(sizeof(double)) <= input.size(); ++i) {
+        double value;
+        std::memcpy(&value, input.data() + at, sizeof(double));
+        meters.append(value);
+        at += sizeof(double);
+    }
+    const QByteArray utf8 = input.sliced(qMin(at, input.size())).toByteArray();
+
+    QStringList mismatches;
+    checkText(utf8, flags & StreamFlag, mismatches);
+    checkParameters(meters, mismatches);
+    checkCombined(QString::fromUtf8(utf8), meters, mismatches);
+    return mismatches;
+}
+
+void DifferentialCheck::checkText(const QByteArray &utf8, bool stream, QStringList &mismatches)
+{
+    const QString text = QString::fromUtf8(utf8);
+    const EmotionDetector::Emotion expected = ReferenceDetector::analyzeText(text);
+
+    compare(mismatches, "analyzeText", detector.analyzeText(text), expected);
+    compare(mismatches, "analyzeUtf8", detector.analyzeUtf8(utf8), expected);
+    if (utf8.isValidUtf8() && Utf8Lexicon::toLower(utf8) != text.toLower().toUtf8())
+        mismatches.append("Utf8Lexicon::toLower: не совпадает с QString::toLower");
+
+    // Куски меньше слова и побольше; совсем мелкие только для коротких текстов
+    for (qsizetype chunkSize : {qsizetype(1), qsizetype(7), text.size() / 8 + 1}) {
+        if (chunkSize * 4096 < text.size())
+            continue;
+        const DocumentAnalyzer::Result result = DocumentAnalyzer::analyzeText(text, true, chunkSize);
+        const QString path = QString("DocumentAnalyzer::analyzeText(%1)").arg(chunkSize);
+        compare(mismatches, path, result.emotion, expected);
+        qint64 covered = 0;
+        for (const DocumentAnalyzer::Section &section : result.sections)
+            covered += section.length;
+        if (covered != text.size() || result.characters != text.size())
+            mismatches.append(QString("%1: разделы покрывают %2 символов из %3").arg(path).arg(covered).arg(text.size()));
+    }
+
+    if (stream) {
+        QTemporaryFile file;
+        if (!file.open() || file.write(utf8) != utf8.size() || !file.flush()) {
+            mismatches.append("analyzeFile: не удалось записать временный файл");
+        } else {
+            // Маленький буфер режет символы и слова на стыках
+            const qsizetype bufferSize = utf8.size() < 65536 ? 16 : 65536;
+            const DocumentAnalyzer::Result result = DocumentAnalyzer::analyzeFile(file.fileName(), false, bufferSize);
+            if (!result.error.isEmpty())
+                mismatches.append("analyzeFile: " + result.error);
+            compare(mismatches, "DocumentAnalyzer::analyzeFile", result.emotion, expected);
+        }
+    }
+
+    tracker.addText(text, ++timestamp);
+    compare(mismatches, "EmotionTracker::addText", tracker.currentEmotion(), expected);
+}
+
+void DifferentialCheck::checkParameters(const QVector<double> &meters, QStringList &mismatches)
+{
+    const EmotionDetector::Emotion expected = ReferenceDetector::analyzeParameters(meters);
+    compare(mismatches, "analyzeParameters", detector.analyzeParameters(meters), expected);
+
+    // Без запаса правило подходит ровно той эмоции, которую выбирает детектор
+    for (int emotion = EmotionDetector::Neutral; emotion <= EmotionDetector::Surprise; ++emotion) {
+        if (EmotionDetector::parametersMatch(EmotionDetector::Emotion(emotion), meters) != (emotion == expected))
+            mismatches.append(QString("parametersMatch(%1): ошибается при эталоне %2")
+                              .arg(emotionName(EmotionDetector::Emotion(emotion)), emotionName(expected)));
+    }
+
+    // Пока показаний меньше MinSamples, норма не применяется
+    BaselineStore store;
+    store.update(1, meters);
+    compare(mismatches, "BaselineStore::classify", store.classify(detector, 1, meters), expected);
+
+    tracker.addParameters(meters, ++timestamp);
+    compare(mismatches, "EmotionTracker::addParameters", tracker.currentEmotion(), expected);
+}
+
+void DifferentialCheck::checkCombined(const QString &text, const QVector<double> &meters, QStringList &mismatches)
+{
+    const EmotionDetector::Emotion expected = ReferenceDetector::combinedAnalysis(text, meters);
+    compare(mismatches, "combinedAnalysis", detector.combinedAnalysis(text, meters), expected);
+
+    tracker.addCombined(text, meters, ++timestamp);
+    compare(mismatches, "EmotionTracker::addCombined", tracker.currentEmotion(), expected);
+}
+
+QByteArray DifferentialCheck::makeInput(const QVector<double> &meters, const QByteArray &text, quint8 flags)
+{
+    Q_ASSERT(meters.size() <= MaxMeters);
+    QByteArray input(1, char((flags & StreamFlag) | (meters.size() << 1)));
+    for (double value : meters)
+        input.append(reinterpret_cast<const char *>(&value), sizeof(double));
+    return input + text;
+}
+
+QByteArray DifferentialCheck::randomInput(QRandomGenerator &random)
+{
+    QVector<double> meters;
+    const int count = random.bounded(3) ? 3 : random.bounded(MaxMeters + 1);
+    for (int i = 0; i < count; ++i)
+        meters.append(randomMeter(random));
+
+    QByteArray text;
+    const int words = random.bounded(40);
+    for (int i = 0; i < words; ++i) {
+        QByteArray word = Words[random.bounded(int(std::size(Words)))];
+        // Изредка длинный повтор: слово за пределами блоков и кусков
+        if (random.bounded(50) == 0)
+            word = word.repeated(1 + random.bounded(3000));
+        text += word;
+        text += Separators[random.bounded(int(std::size(Separators)))];
+    }
+    return makeInput(meters, text, random.bounded(16) ? 0 : StreamFlag);
+}
+
+QList<QByteArray> DifferentialCheck::adversarialInputs()
+{
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    const double inf = std::numeric_limits<double>::infinity();
+    QList<QByteArray> inputs;
+
+    inputs.append(QByteArray());
+    inputs.append(makeInput({}, QByteArray()));
+
+    // Огромные строки: слово длиннее любого буфера, длинные серии слов
+    inputs.append(makeInput({70, 5, 36.6}, QByteArray(1 << 20, 'a') + " happy", StreamFlag));
+    inputs.append(makeInput({}, QByteArray("not ").repeated(100000) + "happy", StreamFlag));
+    inputs.append(makeInput({}, QByteArray("very happy, ").repeated(100000)));
+    inputs.append(makeInput({}, QByteArray("'").repeated(100000) + "happy" + QByteArray("'").repeated(100000)));
+    inputs.append(makeInput({}, QByteArray("\xF0\x9F\x98\x80").repeated(50000) + "lonely", StreamFlag));
+
+    // Необычный Unicode: İ удлиняется в нижнем регистре, диакритика
+    // приклеивается к слову, полноширинные буквы, неверный UTF-8
+    inputs.append(makeInput({}, QByteArray("\xC4\xB0").repeated(5000) + " HAPPY"));
+    inputs.append(makeInput({}, "happy" + QByteArray("\xCC\x87").repeated(10000) + " sad"));
+    inputs.append(makeInput({}, "\xEF\xBC\xA8\xEF\xBC\xA1\xEF\xBC\xB0\xEF\xBC\xB0\xEF\xBC\xB9 \xE2\x84\xAA"));
+    inputs.append(makeInput({}, QByteArray("\xFF").repeated(10000) + "angry\xED\xA0\x80hate\xC0\xAFlove\xE2\x82"));
+    inputs.append(makeInput({}, "\xEF\xBB\xBFI don\xE2\x80\x99t love\xE2\x80\x8Dit", StreamFlag));
+    inputs.append(makeInput({}, QByteArray("happy\0sad\0sad", 13)));
+
+    // Длинные сокращённые отрицания и ASCII вокруг границ 8- и 16-байтных
+    // блоков, которые Utf8Lexicon переводит в нижний регистр за раз
+    inputs.append(makeInput({}, "You SHOULDN\xE2\x80\x99T hate it, " + QByteArray(40, 'x') + "n't love"));
+    for (int size : {7, 8, 9, 15, 16, 17, 31, 32, 33}) {
+        inputs.append(makeInput({}, QByteArray(size - 5, 'A') + " HATE\xC4\xB0 SAD"));
+        inputs.append(makeInput({}, QByteArray(size, '@') + "[`{\xD0\x96Z" + QByteArray(size, 'Z') + " ANGRY"));
+    }
+
+    // Показания: NaN, бесконечности, пороги ровно, короткие и длинные векторы
+    inputs.append(makeInput({nan, nan, nan}, QByteArray()));
+    inputs.append(makeInput({inf, inf, 36.6}, QByteArray()));
+    inputs.append(makeInput({-inf, -inf, 0}, "so happy"));
+    inputs.append(makeInput({nan, 12, 37}, QByteArray()));
+    inputs.append(makeInput({95, nan, 37}, "nothing"));
+    inputs.append(makeInput({85, 8, 36.6}, QByteArray()));
+    inputs.append(makeInput({65, 5, 36.6}, QByteArray()));
+    inputs.append(makeInput({std::numeric_limits<double>::max(), std::numeric_limits<double>::lowest(), 0}, QByteArray()));
+    inputs.append(makeInput({-0.0, -0.0, -0.0}, QByteArray()));
+    inputs.append(makeInput({95}, "not sad"));
+    inputs.append(makeInput({95, 12}, QByteArray()));
+    inputs.append(makeInput({95, 12, 37, nan, inf, -inf, 1}, QByteArray()));
+    return inputs;
+}
@@ -0,0 +1,49 @@
+#ifndef DIFFERENTIALCHECK_H
+#define DIFFERENTIALCHECK_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QList>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QVector>
+#include "emotiondetector.h"
+#include "emotiontracker.h"
+
+// Сверка быстрых путей детектора с ReferenceDetector на одном входе; общая
+// часть fuzz-цели и теста. Вход — байты: первый задаёт флаги и число
+// показаний, дальше показания как double в байтах машины (так в них
+// попадают NaN и бесконечности), остальное — текст в UTF-8, не обязательно
+// верный.
+class DifferentialCheck
+{
+public:
+    // Проверять ли потоковое чтение из файла: оно медленнее остальных
+    static constexpr quint8 StreamFlag = 0x01;
+    static constexpr int MaxMeters = 7;
+
+    explicit DifferentialCheck(const EmotionDetector &detector);
+
+    // Описания расхождений; пустой список — все пути согласны с эталоном
+    QStringList run(QByteArrayView input);
+
+    static QByteArray makeInput(const QVector<double> &meters, const QByteArray &text, quint8 flags = 0);
+    // Случайный вход из словаря слов, которые задевают правила разбора
+    static QByteArray randomInput(QRandomGenerator &random);
+    // Огромные строки, необычный Unicode, неверный UTF-8, NaN и бесконечности
+    // в показаниях, короткие и длинные векторы
+    static QList<QByteArray> adversarialInputs();
+
+private:
+    const EmotionDetector &detector;
+    // Трекер без выдержки и гистерезиса повторяет детектор; его состояние
+    // переходит от входа к входу
+    EmotionTracker tracker;
+    qint64 timestamp = 0;
+
+    void checkText(const QByteArray &utf8, bool stream, QStringList &mismatches);
+    void checkParameters(const QVector<double> &meters, QStringList &mismatches);
+    void checkCombined(const QString &text, const QVector<double> &meters, QStringList &mismatches);
+};
+
+#endif // DIFFERENTIALCHECK_H
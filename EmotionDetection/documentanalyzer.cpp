@@ -0,0 +1,158 @@
+#include "documentanalyzer.h"
+#include <QFile>
+#include <QStringDecoder>
+#include <QThreadPool>
+#include <QtConcurrent>
+
+namespace {
+
+// Сколько символов назад искать пробел, прежде чем резать посреди слова
+const qsizetype MaxWordSearch = 256;
+
+}
+
+// Очередь кусков в работе: не больше, чем потоков в пуле плюс один,
+// итоги складываются в порядке кусков
+class DocumentAnalyzer::Pipeline
+{
+public:
+    Pipeline(Result &result, bool withSections)
+        : result(result), withSections(withSections),
+          maxInFlight(QThreadPool::globalInstance()->maxThreadCount() + 1)
+    {
+        result.keywordCounts.fill(0, EmotionDetector::textKeywords().size());
+    }
+
+    void submit(const QString &context, const QString &text, qsizetype begin, qsizetype end, qint64 offset)
+    {
+        if (inFlight.size() >= maxInFlight)
+            collect(inFlight.takeFirst().result());
+        inFlight.append(QtConcurrent::run(&DocumentAnalyzer::tallyChunk, context, text, begin, end, offset));
+    }
+
+    void finish()
+    {
+        while (!inFlight.isEmpty())
+            collect(inFlight.takeFirst().result());
+        result.emotion = EmotionDetector::wordScanner().emotion(result.scores);
+    }
+
+private:
+    Result &result;
+    bool withSections;
+    qsizetype maxInFlight;
+    QList<QFuture<ChunkTally>> inFlight;
+
+    void collect(const ChunkTally &tally)
+    {
+        for (qsizetype i = 0; i < tally.counts.size(); ++i)
+            result.keywordCounts[i] += tally.counts.at(i);
+        for (int i = 0; i < WordScanner::EmotionCount; ++i)
+            result.scores[i] += tally.scores[i];
+        result.characters += tally.length;
+        if (withSections) {
+            Section section;
+            section.offset = tally.offset;
+            section.length = tally.length;
+            section.emotion = EmotionDetector::wordScanner().emotion(tally.scores);
+            result.sections.append(section);
+        }
+    }
+};
+
+DocumentAnalyzer::Result DocumentAnalyzer::analyzeFile(const QString &filename, bool withSections, qsizetype bufferSize)
+{
+    Result result;
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) {
+        result.error = file.errorString();
+        return result;
+    }
+
+    // Хвост после последнего разреза переходит в следующий кусок, а текст
+    // до разреза — в короткий контекст из нескольких слов. Без пробела кусок
+    // режется так, чтобы за ним уместились самое длинное слово, апостроф и
+    // ещё символ.
+    const WordScanner &scanner = EmotionDetector::wordScanner();
+    const qsizetype lookahead = scanner.longestWord() + 2;
+    QStringDecoder decoder(QStringDecoder::Utf8);
+    QByteArray buffer(qMax<qsizetype>(bufferSize, 16), Qt::Uninitialized);
+    QString pending;
+    QString context;
+    qint64 offset = 0;
+
+    Pipeline pipeline(result, withSections);
+    for (;;) {
+        const qint64 read = file.read(buffer.data(), buffer.size());
+        if (read < 0) {
+            result.error = file.errorString();
+            break;
+        }
+        if (read == 0) {
+            if (!pending.isEmpty())
+                pipeline.submit(context, pending, 0, pending.size(), offset);
+            break;
+        }
+
+        pending += decoder(QByteArrayView(buffer.constData(), read));
+        result.peakPending = qMax(result.peakPending, qint64(pending.size() + context.size()));
+        const qsizetype limit = pending.size() - lookahead;
+        if (limit <= 0)
+            continue;
+        const qsizetype cut = cutPoint(pending, 0, limit);
+        pipeline.submit(context, pending, 0, cut, offset);
+        offset += cut;
+        // Кусок в работе держит прежнюю строку, хвост копируется в новую
+        context = scanner.context(context, QStringView(pending).first(cut));
+        pending = pending.sliced(cut);
+    }
+    pipeline.finish();
+    return result;
+}
+
+DocumentAnalyzer::Result DocumentAnalyzer::analyzeText(const QString &text, bool withSections, qsizetype chunkSize)
+{
+    Result result;
+    Pipeline pipeline(result, withSections);
+    chunkSize = qMax<qsizetype>(chunkSize, 1);
+    const WordScanner &scanner = EmotionDetector::wordScanner();
+    QString context;
+    for (qsizetype begin = 0; begin < text.size();) {
+        const qsizetype end = qMin(text.size(), begin + chunkSize);
+        const qsizetype cut = end == text.size() ? end : cutPoint(text, begin, end);
+        pipeline.submit(context, text, begin, cut, begin);
+        if (cut < text.size())
+            context = scanner.context(context, QStringView(text).sliced(begin, cut - begin));
+        begin = cut;
+    }
+    pipeline.finish();
+    return result;
+}
+
+DocumentAnalyzer::ChunkTally DocumentAnalyzer::tallyChunk(const QString &context, const QString &text, qsizetype begin, qsizetype end, qint64 offset)
+{
+    ChunkTally tally;
+    tally.offset = offset;
+    tally.length = end - begin;
+
+    const WordScanner &scanner = EmotionDetector::wordScanner();
+    tally.counts.fill(0, scanner.keywordCount());
+    WordScanner::Pass pass(scanner, tally.counts.data());
+    WordScanner::scanContext(context, pass);
+    WordScanner::scan(text, begin, end, pass);
+    tally.scores = pass.scores();
+    return tally;
+}
+
+qsizetype DocumentAnalyzer::cutPoint(const QString &text, qsizetype begin, qsizetype end)
+{
+    const qsizetype stop = qMax(begin + 1, end - MaxWordSearch);
+    for (qsizetype i = end - 1; i >= stop; --i) {
+        if (text.at(i).isSpace())
+            return i + 1;
+    }
+    // Суррогатную пару не разрываем
+    if (text.at(end - 1).isHighSurrogate())
+        return end - 1 > begin ? end - 1 : end + 1;
+    return end;
+}
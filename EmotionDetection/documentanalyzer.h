@@ -0,0 +1,67 @@
+#ifndef DOCUMENTANALYZER_H
+#define DOCUMENTANALYZER_H
+
+#include <QFuture>
+#include <QList>
+#include <QString>
+#include "emotiondetector.h"
+#include "wordscanner.h"
+
+// Анализ очень больших документов. Текст режется на куски по границам слов,
+// куски разбираются параллельно, счёт и счётчики ключевых слов складываются.
+// Слово засчитывается куску, в котором оно начинается, поэтому слово на
+// стыке кусков не теряется и не считается дважды; окно отрицаний перед
+// куском восстанавливается по нескольким предыдущим словам. Итоговая эмоция
+// совпадает с EmotionDetector::analyzeText для того же текста.
+class DocumentAnalyzer
+{
+public:
+    struct Section
+    {
+        qint64 offset = 0;  // в символах UTF-16 от начала документа
+        qint64 length = 0;
+        EmotionDetector::Emotion emotion = EmotionDetector::Neutral;
+    };
+
+    struct Result
+    {
+        EmotionDetector::Emotion emotion = EmotionDetector::Neutral;
+        // Число вхождений каждого слова из EmotionDetector::textKeywords()
+        QList<qint64> keywordCounts;
+        // Счёт по эмоциям с учётом отрицаний и усилителей
+        WordScanner::Scores scores = {};
+        // Заполняется, если запрошено: по одному разделу на кусок
+        QList<Section> sections;
+        qint64 characters = 0;
+        // analyzeFile: наибольший объём текста, который ждал разбора, в
+        // символах UTF-16; не зависит от размера файла
+        qint64 peakPending = 0;
+        QString error;
+    };
+
+    static constexpr qsizetype DefaultBufferSize = 4 * 1024 * 1024;
+    static constexpr qsizetype DefaultChunkSize = 1024 * 1024;
+
+    // Файл в UTF-8 читается буферами по bufferSize байт; в памяти держится
+    // лишь несколько кусков на каждый поток пула
+    static Result analyzeFile(const QString &filename, bool withSections = false, qsizetype bufferSize = DefaultBufferSize);
+    static Result analyzeText(const QString &text, bool withSections = false, qsizetype chunkSize = DefaultChunkSize);
+
+private:
+    struct ChunkTally
+    {
+        QList<qint64> counts;
+        WordScanner::Scores scores = {};
+        qint64 offset = 0;
+        qint64 length = 0;
+    };
+
+    // Кусок text[begin, end); последнее слово может заходить за end,
+    // context — сжатый текст перед begin для окна отрицаний
+    static ChunkTally tallyChunk(const QString &context, const QString &text, qsizetype begin, qsizetype end, qint64 offset);
+    static qsizetype cutPoint(const QString &text, qsizetype begin, qsizetype end);
+
+    class Pipeline;
+};
+
+#endif // DOCUMENTANALYZER_H
@@ -1,46 +1,137 @@
 #include "emotiondetector.h"
+#include "analysisscheduler.h"
+#include "utf8lexicon.h"
+#include "wordscanner.h"
 #include <QRegularExpression>
 #include <QDebug>
 #include <cmath>
 
-EmotionDetector::EmotionDetector(QObject *parent) : QObject(parent)
+namespace {
+
+// Пороги analyzeParameters в порядке приоритета. Запас сдвигает пороги
+// в пользу правила: положительный ослабляет условие, отрицательный ужесточает.
+struct ParameterRule
+{
+    EmotionDetector::Emotion emotion;
+    double heartRate;
+    double gsr;
+    bool above;
+
+    bool matches(double heartRateValue, double gsrValue, double heartRateMargin, double gsrMargin) const
+    {
+        if (above)
+            return heartRateValue > heartRate - heartRateMargin && gsrValue > gsr - gsrMargin;
+        return heartRateValue < heartRate + heartRateMargin && gsrValue < gsr + gsrMargin;
+    }
+};
+
+const ParameterRule ParameterRules[] = {
+    {EmotionDetector::Happy, 85, 8, true},
+    {EmotionDetector::Excited, 80, 7, true},
+    {EmotionDetector::Sad, 65, 5, false},
+    {EmotionDetector::Angry, 90, 10, true}
+};
+
+}
+
+EmotionDetector::EmotionDetector(QObject *parent)
+    : QObject(parent)
+{
+}
+
+EmotionDetector::~EmotionDetector() = default;
+
+AnalysisScheduler &EmotionDetector::asyncScheduler() const
 {
+    std::call_once(schedulerCreated, [this] { scheduler = std::make_unique<AnalysisScheduler>(); });
+    return *scheduler;
 }
 
 EmotionDetector::Emotion EmotionDetector::analyzeText(const QString &text) const
 {
     if (text.isEmpty()) return Neutral;
 
-    QString lowerText = text.toLower();
+    WordScanner::Pass pass(wordScanner());
+    WordScanner::scan(text, 0, text.size(), pass);
+    return pass.emotion();
+}
+
+const QList<EmotionDetector::TextKeyword> &EmotionDetector::textKeywords()
+{
+    static const QList<TextKeyword> keywords = {
+        {Happy, QStringView(u"happy")},
+        {Happy, QStringView(u"joy")},
+        {Happy, QStringView(u"love")},
+        {Excited, QStringView(u"excited")},
+        {Excited, QStringView(u"wonderful")},
+        {Sad, QStringView(u"sad")},
+        {Sad, QStringView(u"lonely")},
+        {Angry, QStringView(u"angry")},
+        {Angry, QStringView(u"hate")}
+    };
+    return keywords;
+}
 
-    if (lowerText.contains("happy") || lowerText.contains("joy") || lowerText.contains("love"))
-        return Happy;
-    if (lowerText.contains("excited") || lowerText.contains("wonderful"))
-        return Excited;
-    if (lowerText.contains("sad") || lowerText.contains("lonely"))
-        return Sad;
-    if (lowerText.contains("angry") || lowerText.contains("hate"))
-        return Angry;
+const WordScanner &EmotionDetector::wordScanner()
+{
+    static const WordScanner scanner(textKeywords());
+    return scanner;
+}
 
-    return Neutral;
+EmotionDetector::Emotion EmotionDetector::analyzeUtf8(QByteArrayView text) const
+{
+    static const Utf8Lexicon lexicon(textKeywords());
+    return lexicon.analyze(text);
+}
+
+QFuture<EmotionDetector::Emotion> EmotionDetector::analyzeTextAsync(const QString &text, Priority priority) const
+{
+    return asyncScheduler().submit(priority, [this, text] { return analyzeText(text); });
+}
+
+QFuture<EmotionDetector::Emotion> EmotionDetector::analyzeUtf8Async(const QByteArray &text, Priority priority) const
+{
+    return asyncScheduler().submit(priority, [this, text] { return analyzeUtf8(text); });
+}
+
+QFuture<EmotionDetector::Emotion> EmotionDetector::analyzeParametersAsync(const QVector<double> &meters, Priority priority) const
+{
+    return asyncScheduler().submit(priority, [this, meters] { return analyzeParameters(meters); });
+}
+
+QFuture<EmotionDetector::Emotion> EmotionDetector::combinedAnalysisAsync(const QString &text, const QVector<double> &meters, Priority priority) const
+{
+    return asyncScheduler().submit(priority, [this, text, meters] { return combinedAnalysis(text, meters); });
 }
 
 EmotionDetector::Emotion EmotionDetector::analyzeParameters(const QVector<double> meters) const
 {
     if (meters.isEmpty() || meters.size() < 3) return Neutral;
 
-    double heartRate = meters[0];
-    double gsr = meters[1];
-    double temperature = meters[2];
-
-    if (heartRate > 85 && gsr > 8) return Happy;
-    if (heartRate > 80 && gsr > 7) return Excited;
-    if (heartRate < 65 && gsr < 5) return Sad;
-    if (heartRate > 90 && gsr > 10) return Angry;
+    for (const ParameterRule &rule : ParameterRules) {
+        if (rule.matches(meters[0], meters[1], 0, 0))
+            return rule.emotion;
+    }
 
     return Calm;
 }
 
+bool EmotionDetector::parametersMatch(Emotion emotion, const QVector<double> &meters, double heartRateMargin, double gsrMargin)
+{
+    if (meters.size() < 3) return emotion == Neutral;
+
+    // Правила с более высоким приоритетом должны выполняться с запасом,
+    // а правило самой эмоции — хотя бы с ослабленными порогами
+    for (const ParameterRule &rule : ParameterRules) {
+        if (rule.emotion == emotion)
+            return rule.matches(meters[0], meters[1], heartRateMargin, gsrMargin);
+        if (rule.matches(meters[0], meters[1], -heartRateMargin, -gsrMargin))
+            return false;
+    }
+
+    return emotion == Calm;
+}
+
 EmotionDetector::Emotion EmotionDetector::combinedAnalysis(const QString &text, const QVector<double> meters) const
 {
     if (text.isEmpty() && meters.isEmpty()) return Neutral;
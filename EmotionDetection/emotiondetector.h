@@ -1,8 +1,18 @@
 #ifndef EMOTIONDETECTOR_H
 #define EMOTIONDETECTOR_H
 
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QFuture>
+#include <QList>
 #include <QObject>
+#include <QStringView>
 #include <QVector>
+#include <memory>
+#include <mutex>
+
+class AnalysisScheduler;
+class WordScanner;
 
 class EmotionDetector : public QObject
 {
@@ -22,14 +32,52 @@ public:
     };
     Q_ENUM(Emotion)
 
+    // Класс асинхронной задачи: пользователь ждёт ответа или идёт
+    // фоновый пересчёт
+    enum Priority {
+        Interactive,
+        Bulk
+    };
+    Q_ENUM(Priority)
+
+    struct TextKeyword
+    {
+        Emotion emotion;
+        QStringView text;
+    };
+
     explicit EmotionDetector(QObject *parent = nullptr);
+    ~EmotionDetector() override;
 
     Emotion analyzeText(const QString &text) const;
     Emotion analyzeParameters(const QVector<double> meters) const;
     Emotion combinedAnalysis(const QString &text, const QVector<double> meters) const;
+    // То же, что analyzeText, но прямо по байтам UTF-8, без QString
+    Emotion analyzeUtf8(QByteArrayView text) const;
+
+    // Те же разборы на пуле детектора. Interactive не ждёт очереди Bulk;
+    // при удалении детектора задачи в очереди отменяются. Пул создаётся
+    // при первом вызове, детектор без асинхронных разборов потоков не держит
+    QFuture<Emotion> analyzeTextAsync(const QString &text, Priority priority = Interactive) const;
+    QFuture<Emotion> analyzeUtf8Async(const QByteArray &text, Priority priority = Interactive) const;
+    QFuture<Emotion> analyzeParametersAsync(const QVector<double> &meters, Priority priority = Interactive) const;
+    QFuture<Emotion> combinedAnalysisAsync(const QString &text, const QVector<double> &meters, Priority priority = Interactive) const;
+
     static QString emotionToString(Emotion emotion);
+    // Ключевые слова analyzeText в нижнем регистре; при равном счёте
+    // побеждает эмоция, слово которой раньше в списке
+    static const QList<TextKeyword> &textKeywords();
+    // Разбор на слова, которым пользуется analyzeText
+    static const WordScanner &wordScanner();
+    // Подходят ли показатели под эмоцию, если сдвинуть пороги на запас в её пользу
+    static bool parametersMatch(Emotion emotion, const QVector<double> &meters, double heartRateMargin = 0, double gsrMargin = 0);
 
 private:
+    mutable std::unique_ptr<AnalysisScheduler> scheduler;
+    mutable std::once_flag schedulerCreated;
+
+    AnalysisScheduler &asyncScheduler() const;
+
     double calculateTextScore(const QString &text) const;
     double calculateParametersScore(const QVector<double> meters) const;
 };
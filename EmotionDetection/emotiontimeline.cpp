@@ -0,0 +1,211 @@
+#include "emotiontimeline.h"
+
+namespace {
+
+const qint64 Second = 1000;
+const qint64 Minute = 60 * Second;
+const qint64 Hour = 60 * Minute;
+
+// Сеанс хранит 10 минут по секундам, сутки по минутам и неделю по часам
+const qsizetype SecondBuckets = 600;
+const qsizetype MinuteBuckets = 24 * 60;
+const qsizetype HourBuckets = 7 * 24;
+
+qint64 floorDiv(qint64 value, qint64 divisor)
+{
+    const qint64 quotient = value / divisor;
+    return quotient * divisor > value ? quotient - 1 : quotient;
+}
+
+qint64 ceilDiv(qint64 value, qint64 divisor)
+{
+    return -floorDiv(-value, divisor);
+}
+
+}
+
+EmotionTimeline::EmotionTimeline()
+    : raw(RawCapacity),
+      levels{Level(Second, SecondBuckets), Level(Minute, MinuteBuckets), Level(Hour, HourBuckets)}
+{
+}
+
+void EmotionTimeline::add(EmotionDetector::Emotion emotion, qint64 timestamp)
+{
+    if (emotion < 0 || emotion >= EmotionCount)
+        return;
+
+    raw[rawNext] = Entry{timestamp, emotion};
+    rawNext = (rawNext + 1) % RawCapacity;
+    rawSize = qMin(rawSize + 1, RawCapacity);
+    latest = rawSize == 1 ? timestamp : qMax(latest, timestamp);
+
+    for (Level &level : levels)
+        level.add(emotion, timestamp);
+}
+
+QList<EmotionTimeline::Entry> EmotionTimeline::recent(qint64 since) const
+{
+    QList<Entry> result;
+    const qint64 from = qMax(since, latest - RawWindow);
+    for (qsizetype i = 0; i < rawSize; ++i) {
+        const Entry &entry = raw.at((rawNext - rawSize + i + RawCapacity) % RawCapacity);
+        if (entry.timestamp >= from)
+            result.append(entry);
+    }
+    return result;
+}
+
+EmotionTimeline::Histogram EmotionTimeline::distribution(qint64 from, qint64 to) const
+{
+    // Интервал делится между уровнями без перекрытий: свежая часть
+    // считается по секундам, более старая по минутам, самая старая по часам
+    Histogram result = {};
+    qint64 upper = to;
+    for (qsizetype i = 0; i < qsizetype(levels.size()) && from < upper; ++i) {
+        const Level &level = levels[i];
+        qint64 lower = from;
+        if (i + 1 < qsizetype(levels.size()))
+            lower = qMax(from, level.coveredFrom(levels[i + 1].resolution()));
+        if (lower < upper)
+            level.sum(floorDiv(lower, level.resolution()), ceilDiv(upper, level.resolution()), result);
+        upper = qMin(upper, lower);
+    }
+    return result;
+}
+
+quint64 EmotionTimeline::total(const Histogram &histogram)
+{
+    quint64 sum = 0;
+    for (quint32 count : histogram)
+        sum += count;
+    return sum;
+}
+
+qsizetype EmotionTimeline::memoryUsage() const
+{
+    qsizetype usage = qsizetype(sizeof(EmotionTimeline)) + raw.size() * qsizetype(sizeof(Entry));
+    for (const Level &level : levels)
+        usage += level.memoryUsage();
+    return usage;
+}
+
+void EmotionTimeline::clear()
+{
+    rawNext = 0;
+    rawSize = 0;
+    latest = 0;
+    for (Level &level : levels)
+        level.clear();
+}
+
+EmotionTimeline::Level::Level(qint64 resolution, qsizetype capacity)
+    : step(resolution), buckets(capacity), tree(capacity + 1)
+{
+}
+
+void EmotionTimeline::Level::add(EmotionDetector::Emotion emotion, qint64 timestamp)
+{
+    const qint64 index = floorDiv(timestamp, step);
+    if (!empty && index < oldest())
+        return;
+    if (empty || index > newest)
+        advance(index);
+
+    const qsizetype slot = slotOf(index);
+    if (buckets[slot].index != index) {
+        evict(slot);
+        buckets[slot].index = index;
+    }
+    ++buckets[slot].counts[emotion];
+    treeAdd(slot, emotion, 1);
+}
+
+void EmotionTimeline::Level::sum(qint64 first, qint64 last, Histogram &result) const
+{
+    if (empty)
+        return;
+    first = qMax(first, oldest());
+    last = qMin(last, newest + 1);
+    if (first >= last)
+        return;
+
+    // Диапазон корзин в кольце — один или два непрерывных участка
+    const qsizetype begin = slotOf(first);
+    const qsizetype end = slotOf(last - 1) + 1;
+    if (begin < end) {
+        prefix(end, result, false);
+        prefix(begin, result, true);
+    } else {
+        prefix(buckets.size(), result, false);
+        prefix(begin, result, true);
+        prefix(end, result, false);
+    }
+}
+
+qint64 EmotionTimeline::Level::coveredFrom(qint64 coarser) const
+{
+    if (empty)
+        return std::numeric_limits<qint64>::max();
+    return ceilDiv(oldest() * step, coarser) * coarser;
+}
+
+qsizetype EmotionTimeline::Level::memoryUsage() const
+{
+    return buckets.size() * qsizetype(sizeof(Bucket)) + tree.size() * qsizetype(sizeof(Histogram));
+}
+
+void EmotionTimeline::Level::clear()
+{
+    buckets.fill(Bucket());
+    tree.fill(Histogram());
+    newest = 0;
+    empty = true;
+}
+
+qsizetype EmotionTimeline::Level::slotOf(qint64 index) const
+{
+    const qint64 slot = index % buckets.size();
+    return qsizetype(slot < 0 ? slot + buckets.size() : slot);
+}
+
+void EmotionTimeline::Level::advance(qint64 index)
+{
+    // Корзины, которые выпадают из окна, вычитаются из дерева сразу,
+    // иначе их показания попали бы в запросы
+    if (empty || index - newest >= buckets.size()) {
+        buckets.fill(Bucket());
+        tree.fill(Histogram());
+    } else {
+        for (qint64 i = newest + 1; i <= index; ++i)
+            evict(slotOf(i));
+    }
+    newest = index;
+    empty = false;
+}
+
+void EmotionTimeline::Level::evict(qsizetype slot)
+{
+    Bucket &bucket = buckets[slot];
+    for (int emotion = 0; emotion < EmotionCount; ++emotion) {
+        if (bucket.counts[emotion])
+            treeAdd(slot, emotion, 0u - bucket.counts[emotion]);
+    }
+    bucket = Bucket();
+}
+
+void EmotionTimeline::Level::treeAdd(qsizetype slot, int emotion, quint32 delta)
+{
+    // Беззнаковое сложение по модулю 2^32 позволяет и вычитать
+    for (qsizetype i = slot + 1; i < tree.size(); i += i & -i)
+        tree[i][emotion] += delta;
+}
+
+void EmotionTimeline::Level::prefix(qsizetype end, Histogram &result, bool subtract) const
+{
+    for (qsizetype i = end; i > 0; i -= i & -i) {
+        const Histogram &node = tree.at(i);
+        for (int emotion = 0; emotion < EmotionCount; ++emotion)
+            result[emotion] = subtract ? result[emotion] - node[emotion] : result[emotion] + node[emotion];
+    }
+}
@@ -0,0 +1,88 @@
+#ifndef EMOTIONTIMELINE_H
+#define EMOTIONTIMELINE_H
+
+#include <QList>
+#include <array>
+#include <limits>
+#include "emotiondetector.h"
+
+// История эмоций сеанса ограниченного размера. Последние показания
+// хранятся как есть, остальное — гистограммами по секундам, минутам и
+// часам. Каждый уровень — кольцо корзин с деревом Фенвика, поэтому
+// распределение за любой интервал считается за логарифмическое время.
+// Память выделяется один раз в конструкторе и дальше не растёт.
+class EmotionTimeline
+{
+public:
+    static constexpr int EmotionCount = EmotionDetector::Surprise + 1;
+    using Histogram = std::array<quint32, EmotionCount>;
+
+    struct Entry
+    {
+        qint64 timestamp = 0;
+        EmotionDetector::Emotion emotion = EmotionDetector::Neutral;
+    };
+
+    // Показания за последнюю минуту, но не больше RawCapacity
+    static constexpr qsizetype RawCapacity = 1024;
+    static constexpr qint64 RawWindow = 60 * 1000;
+
+    EmotionTimeline();
+
+    // Время в миллисекундах; слишком старые показания отбрасываются
+    void add(EmotionDetector::Emotion emotion, qint64 timestamp);
+    QList<Entry> recent(qint64 since) const;
+
+    // Распределение за [from, to). Границы округляются наружу до корзины
+    // самого подробного уровня, который ещё хранит этот участок.
+    Histogram distribution(qint64 from, qint64 to) const;
+    static quint64 total(const Histogram &histogram);
+
+    qsizetype memoryUsage() const;
+    void clear();
+
+private:
+    class Level
+    {
+    public:
+        Level(qint64 resolution, qsizetype capacity);
+
+        qint64 resolution() const { return step; }
+        void add(EmotionDetector::Emotion emotion, qint64 timestamp);
+        // Сумма по корзинам [first, last)
+        void sum(qint64 first, qint64 last, Histogram &result) const;
+        // Начиная с этого момента, кратного coarser, уровень хранит всё
+        qint64 coveredFrom(qint64 coarser) const;
+        qsizetype memoryUsage() const;
+        void clear();
+
+    private:
+        struct Bucket
+        {
+            qint64 index = std::numeric_limits<qint64>::min();
+            Histogram counts = {};
+        };
+
+        qint64 step;
+        QList<Bucket> buckets;
+        QList<Histogram> tree;
+        qint64 newest = 0;
+        bool empty = true;
+
+        qint64 oldest() const { return newest - buckets.size() + 1; }
+        qsizetype slotOf(qint64 index) const;
+        void advance(qint64 index);
+        void evict(qsizetype slot);
+        void treeAdd(qsizetype slot, int emotion, quint32 delta);
+        // Прибавляет (или вычитает) сумму по ячейкам [0, end)
+        void prefix(qsizetype end, Histogram &result, bool subtract) const;
+    };
+
+    QList<Entry> raw;
+    qsizetype rawNext = 0;
+    qsizetype rawSize = 0;
+    qint64 latest = 0;
+    std::array<Level, 3> levels;
+};
+
+#endif // EMOTIONTIMELINE_H
@@ -0,0 +1,97 @@
+#include "emotiontracker.h"
+#include <algorithm>
+
+EmotionTracker::EmotionTracker(const EmotionDetector *detector, QObject *parent)
+    : QObject(parent), detector(detector)
+{
+}
+
+void EmotionTracker::addText(const QString &text, qint64 timestamp)
+{
+    addVote(detector->analyzeText(text), timestamp);
+}
+
+void EmotionTracker::addParameters(const QVector<double> &meters, qint64 timestamp)
+{
+    addVote(classifyParameters(meters), timestamp);
+}
+
+void EmotionTracker::addCombined(const QString &text, const QVector<double> &meters, qint64 timestamp)
+{
+    // Тот же приоритет, что в combinedAnalysis: текст решает, если он не нейтральный
+    const EmotionDetector::Emotion textEmotion = text.isEmpty() ? EmotionDetector::Neutral : detector->analyzeText(text);
+    if (textEmotion != EmotionDetector::Neutral || meters.isEmpty())
+        addVote(textEmotion, timestamp);
+    else
+        addVote(classifyParameters(meters), timestamp);
+}
+
+void EmotionTracker::setMinimumDwell(qint64 milliseconds)
+{
+    dwell = qMax<qint64>(0, milliseconds);
+}
+
+void EmotionTracker::setHysteresis(EmotionDetector::Emotion emotion, double heartRate, double gsr)
+{
+    if (emotion < 0 || emotion >= EmotionCount)
+        return;
+    margins[emotion].heartRate = qMax(0.0, heartRate);
+    margins[emotion].gsr = qMax(0.0, gsr);
+}
+
+void EmotionTracker::reset()
+{
+    stable = EmotionDetector::Neutral;
+    stableConfidence = 0;
+    clearWindow();
+}
+
+EmotionDetector::Emotion EmotionTracker::classifyParameters(const QVector<double> &meters) const
+{
+    // Пока показатели не вышли за пороги с запасом, эмоция остаётся прежней
+    const Margin &margin = margins[stable];
+    if (EmotionDetector::parametersMatch(stable, meters, margin.heartRate, margin.gsr))
+        return stable;
+    return detector->analyzeParameters(meters);
+}
+
+void EmotionTracker::addVote(EmotionDetector::Emotion emotion, qint64 timestamp)
+{
+    if (emotion < 0 || emotion >= EmotionCount)
+        return;
+
+    if (windowVotes == 0) {
+        if (emotion == stable)
+            return;
+        windowStart = timestamp;
+    }
+    ++votes[emotion];
+    ++windowVotes;
+
+    // Кратковременный выброс: текущая эмоция снова в большинстве
+    if (2 * votes[stable] > windowVotes) {
+        clearWindow();
+        return;
+    }
+    if (timestamp - windowStart < dwell)
+        return;
+
+    const auto leader = std::max_element(votes.begin(), votes.end());
+    if (2 * *leader <= windowVotes) {
+        // Явного победителя нет — окно начнётся заново со следующего отличия
+        clearWindow();
+        return;
+    }
+
+    stable = EmotionDetector::Emotion(leader - votes.begin());
+    stableConfidence = double(*leader) / windowVotes;
+    clearWindow();
+    emit emotionChanged(stable, stableConfidence);
+}
+
+void EmotionTracker::clearWindow()
+{
+    votes.fill(0);
+    windowVotes = 0;
+    windowStart = 0;
+}
@@ -0,0 +1,63 @@
+#ifndef EMOTIONTRACKER_H
+#define EMOTIONTRACKER_H
+
+#include <QObject>
+#include <QVector>
+#include <array>
+#include "emotiondetector.h"
+
+// Отслеживает эмоцию по потоку показаний и сообщает только об устойчивых
+// сменах. Показатели датчиков сравниваются с порогами, сдвинутыми в пользу
+// текущей эмоции (гистерезис), а новая эмоция принимается, если она набрала
+// большинство показаний за время не меньше минимальной выдержки.
+class EmotionTracker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit EmotionTracker(const EmotionDetector *detector, QObject *parent = nullptr);
+
+    // Время указывается в миллисекундах и не должно убывать
+    void addText(const QString &text, qint64 timestamp);
+    void addParameters(const QVector<double> &meters, qint64 timestamp);
+    void addCombined(const QString &text, const QVector<double> &meters, qint64 timestamp);
+
+    void setMinimumDwell(qint64 milliseconds);
+    qint64 minimumDwell() const { return dwell; }
+    // Запас по пульсу (уд/мин) и GSR, который удерживает эмоцию у порога
+    void setHysteresis(EmotionDetector::Emotion emotion, double heartRate, double gsr);
+
+    EmotionDetector::Emotion currentEmotion() const { return stable; }
+    double confidence() const { return stableConfidence; }
+    void reset();
+
+signals:
+    void emotionChanged(EmotionDetector::Emotion emotion, double confidence);
+
+private:
+    struct Margin
+    {
+        double heartRate = 3;
+        double gsr = 0.5;
+    };
+
+    static constexpr int EmotionCount = EmotionDetector::Surprise + 1;
+
+    const EmotionDetector *detector;
+    std::array<Margin, EmotionCount> margins;
+    qint64 dwell = 1000;
+
+    EmotionDetector::Emotion stable = EmotionDetector::Neutral;
+    double stableConfidence = 0;
+
+    // Окно с первого показания, отличного от текущей эмоции
+    std::array<int, EmotionCount> votes = {};
+    int windowVotes = 0;
+    qint64 windowStart = 0;
+
+    EmotionDetector::Emotion classifyParameters(const QVector<double> &meters) const;
+    void addVote(EmotionDetector::Emotion emotion, qint64 timestamp);
+    void clearWindow();
+};
+
+#endif // EMOTIONTRACKER_H
@@ -0,0 +1,76 @@
+#include <QFile>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <cstdlib>
+#include "differentialcheck.h"
+#include "emotiondetector.h"
+
+#ifdef EMOTION_LIBFUZZER
+
+// Цель для libFuzzer: любое расхождение с эталоном — падение с описанием
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size)
+{
+    static const EmotionDetector detector;
+    static DifferentialCheck check(detector);
+    const QStringList mismatches = check.run(QByteArrayView(data, qsizetype(size)));
+    if (!mismatches.isEmpty()) {
+        QTextStream(stderr) << mismatches.join('\n') << Qt::endl;
+        std::abort();
+    }
+    return 0;
+}
+
+#else
+
+namespace {
+
+void report(const QByteArray &input, const QStringList &mismatches, int &found)
+{
+    if (mismatches.isEmpty())
+        return;
+    const QString filename = QString("mismatch-%1.bin").arg(++found);
+    QFile file(filename);
+    if (file.open(QIODevice::WriteOnly))
+        file.write(input);
+    QTextStream(stderr) << filename << ":\n  " << mismatches.join("\n  ") << Qt::endl;
+}
+
+}
+
+// Без libFuzzer: fuzzdetector файл... — проверить сохранённые входы;
+// fuzzdetector [число входов [seed]] — граничные и случайные входы
+int main(int argc, char *argv[])
+{
+    const EmotionDetector detector;
+    DifferentialCheck check(detector);
+    int found = 0;
+
+    bool isNumber = argc > 1;
+    const qint64 iterations = argc > 1 ? QByteArray(argv[1]).toLongLong(&isNumber) : 100000;
+    if (argc > 1 && !isNumber) {
+        for (int i = 1; i < argc; ++i) {
+            QFile file(argv[i]);
+            if (!file.open(QIODevice::ReadOnly)) {
+                QTextStream(stderr) << argv[i] << ": " << file.errorString() << Qt::endl;
+                return 2;
+            }
+            const QByteArray input = file.readAll();
+            report(input, check.run(input), found);
+        }
+        return found ? 1 : 0;
+    }
+
+    for (const QByteArray &input : DifferentialCheck::adversarialInputs())
+        report(input, check.run(input), found);
+
+    const quint32 seed = argc > 2 ? QByteArray(argv[2]).toUInt() : QRandomGenerator::global()->generate();
+    QTextStream(stdout) << "seed " << seed << Qt::endl;
+    QRandomGenerator random(seed);
+    for (qint64 i = 0; i < iterations && found < 10; ++i) {
+        const QByteArray input = DifferentialCheck::randomInput(random);
+        report(input, check.run(input), found);
+    }
+    return found ? 1 : 0;
+}
+
+#endif
@@ -0,0 +1,139 @@
+#include "referencedetector.h"
+#include <QStringList>
+#include <array>
+
+namespace {
+
+const int Window = 3;
+
+const QStringList Negators = {"not", "no", "never", "cannot"};
+const QStringList Intensifiers = {"very", "so", "really", "extremely", "totally", "truly"};
+
+QList<char32_t> codePoints(const QString &text)
+{
+    QList<char32_t> result;
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        if (text.at(i).isHighSurrogate() && i + 1 < text.size() && text.at(i + 1).isLowSurrogate()) {
+            result.append(QChar::surrogateToUcs4(text.at(i), text.at(i + 1)));
+            ++i;
+        } else {
+            result.append(text.at(i).unicode());
+        }
+    }
+    return result;
+}
+
+bool isWordCharacter(char32_t code)
+{
+    return QChar::isLetterOrNumber(code) || QChar::isMark(code);
+}
+
+bool isApostrophe(char32_t code)
+{
+    return code == U'\'' || code == 0x2019;
+}
+
+bool isClauseEnd(char32_t code)
+{
+    return code == U'.' || code == U',' || code == U';' || code == U':' || code == U'!' || code == U'?';
+}
+
+}
+
+EmotionDetector::Emotion ReferenceDetector::analyzeText(const QString &text)
+{
+    std::array<qint64, EmotionDetector::Surprise + 1> scores = {};
+    QList<WordKind> window;
+    for (const Token &token : tokenize(text.toLower())) {
+        if (token.clauseEnd) {
+            window.clear();
+            continue;
+        }
+        EmotionDetector::Emotion emotion = EmotionDetector::Neutral;
+        const WordKind kind = classify(token.word, emotion);
+        if (kind == Keyword) {
+            qint64 weight = window.contains(Intensifier) ? 2 : 1;
+            if (window.contains(Negator))
+                weight = -weight;
+            scores[emotion] += weight;
+        }
+        window.append(kind);
+        if (window.size() > Window)
+            window.removeFirst();
+    }
+
+    // Наибольший положительный счёт; при равенстве — эмоция, слово которой раньше в списке
+    EmotionDetector::Emotion best = EmotionDetector::Neutral;
+    for (const EmotionDetector::TextKeyword &keyword : EmotionDetector::textKeywords()) {
+        if (scores[keyword.emotion] > 0 && scores[keyword.emotion] > scores[best])
+            best = keyword.emotion;
+    }
+    return best;
+}
+
+EmotionDetector::Emotion ReferenceDetector::analyzeParameters(const QVector<double> &meters)
+{
+    if (meters.size() < 3) return EmotionDetector::Neutral;
+
+    const double heartRate = meters[0];
+    const double gsr = meters[1];
+
+    if (heartRate > 85 && gsr > 8) return EmotionDetector::Happy;
+    if (heartRate > 80 && gsr > 7) return EmotionDetector::Excited;
+    if (heartRate < 65 && gsr < 5) return EmotionDetector::Sad;
+    if (heartRate > 90 && gsr > 10) return EmotionDetector::Angry;
+
+    return EmotionDetector::Calm;
+}
+
+EmotionDetector::Emotion ReferenceDetector::combinedAnalysis(const QString &text, const QVector<double> &meters)
+{
+    if (text.isEmpty() && meters.isEmpty()) return EmotionDetector::Neutral;
+    if (text.isEmpty()) return analyzeParameters(meters);
+    if (meters.isEmpty()) return analyzeText(text);
+
+    const EmotionDetector::Emotion textEmotion = analyzeText(text);
+    if (textEmotion != EmotionDetector::Neutral) return textEmotion;
+
+    return analyzeParameters(meters);
+}
+
+QList<ReferenceDetector::Token> ReferenceDetector::tokenize(const QString &lowered)
+{
+    // Апостроф входит в слово, только если с обеих сторон буквы
+    const QList<char32_t> codes = codePoints(lowered);
+    QList<Token> tokens;
+    QString word;
+    for (qsizetype i = 0; i < codes.size(); ++i) {
+        const char32_t code = codes.at(i);
+        const bool joins = isApostrophe(code) && !word.isEmpty() && i + 1 < codes.size() && isWordCharacter(codes.at(i + 1));
+        if (isWordCharacter(code) || joins) {
+            word += QString::fromUcs4(&code, 1);
+            continue;
+        }
+        if (!word.isEmpty())
+            tokens.append(Token{word, false});
+        word.clear();
+        if (isClauseEnd(code))
+            tokens.append(Token{QString(), true});
+    }
+    if (!word.isEmpty())
+        tokens.append(Token{word, false});
+    return tokens;
+}
+
+ReferenceDetector::WordKind ReferenceDetector::classify(const QString &word, EmotionDetector::Emotion &emotion)
+{
+    // По определению, без ограничений длины, которые есть у быстрого разбора
+    for (const EmotionDetector::TextKeyword &keyword : EmotionDetector::textKeywords()) {
+        if (word == keyword.text.toString().toLower()) {
+            emotion = keyword.emotion;
+            return Keyword;
+        }
+    }
+    if (Negators.contains(word) || word.endsWith(QStringLiteral("n't")) || word.endsWith(QString::fromUtf8("n\xE2\x80\x99t")))
+        return Negator;
+    if (Intensifiers.contains(word))
+        return Intensifier;
+    return Other;
+}
@@ -0,0 +1,38 @@
+#ifndef REFERENCEDETECTOR_H
+#define REFERENCEDETECTOR_H
+
+#include <QList>
+#include <QString>
+#include <QVector>
+#include "emotiondetector.h"
+
+// Эталон для проверки быстрых путей: правила EmotionDetector, записанные
+// прямо по определению — строка целиком в нижнем регистре, список слов,
+// окно списком, пороги цепочкой условий. Медленный, только для проверок.
+class ReferenceDetector
+{
+public:
+    static EmotionDetector::Emotion analyzeText(const QString &text);
+    static EmotionDetector::Emotion analyzeParameters(const QVector<double> &meters);
+    static EmotionDetector::Emotion combinedAnalysis(const QString &text, const QVector<double> &meters);
+
+private:
+    enum WordKind {
+        Keyword,
+        Negator,
+        Intensifier,
+        Other
+    };
+
+    // Слово или знак конца фразы (тогда word пуст)
+    struct Token
+    {
+        QString word;
+        bool clauseEnd = false;
+    };
+
+    static QList<Token> tokenize(const QString &lowered);
+    static WordKind classify(const QString &word, EmotionDetector::Emotion &emotion);
+};
+
+#endif // REFERENCEDETECTOR_H
@@ -0,0 +1,68 @@
+#include "syntheticcorpus.h"
+#include "emotiondetector.h"
+#include <QRandomGenerator>
+
+namespace {
+
+// Ни одно слово не содержит ключевых слов анализатора
+const char *const FillerWords[] = {
+    "the", "a", "day", "we", "went", "to", "market", "morning", "coffee", "after",
+    "meeting", "about", "project", "report", "with", "team", "then", "call", "from", "office",
+    "back", "home", "dinner", "quiet", "evening", "walk", "park", "weather", "rain", "train",
+    "ticket", "station", "window", "book", "page", "news", "phone", "message", "later", "tomorrow",
+    "week", "plan", "table", "chair", "street"
+};
+
+double clampTo(double value, double low, double high)
+{
+    return qBound(low, value, high);
+}
+
+}
+
+QStringList SyntheticCorpus::messages(int count, double keywordDensity, quint32 seed, int meanWords)
+{
+    QRandomGenerator random(seed);
+    const QList<EmotionDetector::TextKeyword> &keywords = EmotionDetector::textKeywords();
+    const double stop = 1.0 / qMax(1, meanWords);
+
+    QStringList result;
+    result.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        QString message;
+        do {
+            if (!message.isEmpty())
+                message += QLatin1Char(' ');
+            if (random.generateDouble() < keywordDensity)
+                message += keywords.at(random.bounded(int(keywords.size()))).text;
+            else
+                message += QLatin1StringView(FillerWords[random.bounded(int(std::size(FillerWords)))]);
+        } while (random.generateDouble() >= stop && message.size() < 4096);
+
+        // Половина сообщений с заглавной буквы: так toLower действительно копирует
+        if (random.bounded(2))
+            message[0] = message.at(0).toUpper();
+        message += random.bounded(4) ? QLatin1Char('.') : QLatin1Char('!');
+        result.append(message);
+    }
+    return result;
+}
+
+QList<QVector<double>> SyntheticCorpus::sensorTrace(int count, quint32 seed)
+{
+    QRandomGenerator random(seed);
+    double heartRate = 72;
+    double gsr = 6;
+    double temperature = 36.6;
+
+    QList<QVector<double>> result;
+    result.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        // Сумма двух равномерных величин: малые шаги чаще крупных
+        heartRate = clampTo(heartRate + 3 * (random.generateDouble() + random.generateDouble() - 1), 50, 120);
+        gsr = clampTo(gsr + 0.5 * (random.generateDouble() + random.generateDouble() - 1), 1, 14);
+        temperature = clampTo(temperature + 0.05 * (random.generateDouble() - 0.5), 35.5, 38);
+        result.append(QVector<double>{heartRate, gsr, temperature});
+    }
+    return result;
+}
@@ -0,0 +1,22 @@
+#ifndef SYNTHETICCORPUS_H
+#define SYNTHETICCORPUS_H
+
+#include <QList>
+#include <QStringList>
+#include <QVector>
+
+// Детерминированные входные данные для нагрузочных проверок: при одном
+// и том же seed содержимое совпадает, поэтому замеры разных версий сравнимы
+class SyntheticCorpus
+{
+public:
+    // Сообщения со средней длиной meanWords слов (геометрическое распределение);
+    // каждое слово с вероятностью keywordDensity — ключевое слово анализатора
+    static QStringList messages(int count, double keywordDensity, quint32 seed, int meanWords = 12);
+
+    // Показания пульса, GSR и температуры: случайное блуждание с заходами
+    // к порогам analyzeParameters
+    static QList<QVector<double>> sensorTrace(int count, quint32 seed);
+};
+
+#endif // SYNTHETICCORPUS_H
@@ -1,4 +1,10 @@
 #include "testemotiondetector.h"
+#include <QRegularExpression>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <thread>
 
 void TestEmotionDetector::initTestCase()
 {
@@ -21,6 +27,16 @@ void TestEmotionDetector::testTextAnalysis_data()
     QTest::newRow("sad") << "Feeling very sad and lonely" << EmotionDetector::Sad;
     QTest::newRow("angry") << "I hate this! It makes me angry!" << EmotionDetector::Angry;
     QTest::newRow("neutral") << "Just a regular day, nothing special." << EmotionDetector::Neutral;
+    QTest::newRow("whole words only") << "On a crusade against hateful spam" << EmotionDetector::Neutral;
+    QTest::newRow("negation") << "I'm not happy" << EmotionDetector::Neutral;
+    QTest::newRow("contraction") << "I don't love this" << EmotionDetector::Neutral;
+    QTest::newRow("negation cancels") << QString::fromUtf8("I don\xE2\x80\x99t hate it, I love it") << EmotionDetector::Happy;
+    QTest::newRow("long contraction") << QString::fromUtf8("I couldn\xE2\x80\x99t be happy") << EmotionDetector::Neutral;
+    QTest::newRow("longer contraction") << QString::fromUtf8("You shouldn\xE2\x80\x99t hate it") << EmotionDetector::Neutral;
+    QTest::newRow("negation out of window") << "not the slightest bit happy" << EmotionDetector::Happy;
+    QTest::newRow("clause resets negation") << "It was not late. Happy now" << EmotionDetector::Happy;
+    QTest::newRow("intensifier") << "A little happy but very angry" << EmotionDetector::Angry;
+    QTest::newRow("tie keeps priority") << "sad and happy" << EmotionDetector::Happy;
     //QTest::newRow("mixed") << "I'm happy but also a bit upset" << EmotionDetector::Neutral;
 }
 
@@ -114,4 +130,826 @@ void TestEmotionDetector::testEmotionToString()
     QCOMPARE(EmotionDetector::emotionToString(static_cast<EmotionDetector::Emotion>(999)), "Neutral");
 }
 
+static QVector<QVector<double>> repeated(const QVector<double> &meters, int count)
+{
+    return QVector<QVector<double>>(count, meters);
+}
+
+void TestEmotionDetector::testTracker_data()
+{
+    QTest::addColumn<QVector<QVector<double>>>("readings");
+    QTest::addColumn<QList<EmotionDetector::Emotion>>("expected");
+
+    const QVector<double> calm{70, 5, 36.6};
+    const QVector<double> happy{95, 12, 37.0};
+
+    QTest::newRow("stable calm") << repeated(calm, 8) << QList<EmotionDetector::Emotion>{EmotionDetector::Calm};
+
+    // Пульс скачет вокруг порога 85: без трекера каждое показание меняло бы эмоцию
+    QVector<QVector<double>> flapping;
+    for (int i = 0; i < 8; ++i)
+        flapping.append(QVector<double>{i % 2 ? 86.0 : 84.0, 9, 36.6});
+    QTest::newRow("flapping at threshold") << flapping << QList<EmotionDetector::Emotion>{EmotionDetector::Excited};
+
+    QTest::newRow("sustained change")
+        << repeated(calm, 8) + repeated(happy, 8)
+        << QList<EmotionDetector::Emotion>{EmotionDetector::Calm, EmotionDetector::Happy};
+
+    QTest::newRow("short spike")
+        << repeated(calm, 8) + repeated(happy, 2) + repeated(calm, 6)
+        << QList<EmotionDetector::Emotion>{EmotionDetector::Calm};
+}
+
+void TestEmotionDetector::testTracker()
+{
+    QFETCH(QVector<QVector<double>>, readings);
+    QFETCH(QList<EmotionDetector::Emotion>, expected);
+
+    // Показания каждые 250 мс, выдержка 1 с
+    EmotionTracker tracker(detector);
+    QSignalSpy spy(&tracker, &EmotionTracker::emotionChanged);
+    for (int i = 0; i < readings.size(); ++i)
+        tracker.addParameters(readings.at(i), i * 250);
+
+    QList<EmotionDetector::Emotion> emitted;
+    for (const QList<QVariant> &arguments : spy)
+        emitted.append(arguments.at(0).value<EmotionDetector::Emotion>());
+    QCOMPARE(emitted, expected);
+    QCOMPARE(tracker.currentEmotion(), expected.last());
+}
+
+void TestEmotionDetector::testTrackerText()
+{
+    EmotionTracker tracker(detector);
+    tracker.setMinimumDwell(500);
+    QSignalSpy spy(&tracker, &EmotionTracker::emotionChanged);
+
+    tracker.addText("I'm so happy", 0);
+    tracker.addText("nothing special", 200);
+    QCOMPARE(spy.count(), 0);
+
+    tracker.addText("happy again", 400);
+    tracker.addText("still happy", 600);
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).value<EmotionDetector::Emotion>(), EmotionDetector::Happy);
+    QCOMPARE(spy.at(0).at(1).toDouble(), 0.75);
+
+    tracker.reset();
+    QCOMPARE(tracker.currentEmotion(), EmotionDetector::Neutral);
+}
+
+// Покой с небольшим разбросом: пульс ±2, GSR ±0.5
+static void feedResting(BaselineStore &store, quint64 userId, double heartRate, double gsr, int readings)
+{
+    for (int i = 0; i < readings; ++i) {
+        const double sign = i % 2 ? 1 : -1;
+        store.update(userId, QVector<double>{heartRate + 2 * sign, gsr + 0.5 * sign, 36.6});
+    }
+}
+
+void TestEmotionDetector::testBaseline_data()
+{
+    QTest::addColumn<double>("restingHeartRate");
+    QTest::addColumn<double>("restingGsr");
+    QTest::addColumn<int>("readings");
+    QTest::addColumn<QVector<double>>("parameters");
+    QTest::addColumn<EmotionDetector::Emotion>("expected");
+
+    QTest::newRow("high resting rate") << 95.0 << 9.0 << 100 << QVector<double>{95, 9, 36.6} << EmotionDetector::Calm;
+    QTest::newRow("low resting rate") << 55.0 << 3.0 << 100 << QVector<double>{55, 3, 36.6} << EmotionDetector::Calm;
+    QTest::newRow("aroused from low rest") << 55.0 << 3.0 << 100 << QVector<double>{70, 5, 36.6} << EmotionDetector::Happy;
+    QTest::newRow("below own norm") << 55.0 << 3.0 << 100 << QVector<double>{45, 2, 36.6} << EmotionDetector::Sad;
+    // Пока показаний мало, действуют общие пороги
+    QTest::newRow("not enough readings") << 95.0 << 9.0 << 5 << QVector<double>{95, 9, 36.6} << EmotionDetector::Happy;
+}
+
+void TestEmotionDetector::testBaseline()
+{
+    QFETCH(double, restingHeartRate);
+    QFETCH(double, restingGsr);
+    QFETCH(int, readings);
+    QFETCH(QVector<double>, parameters);
+    QFETCH(EmotionDetector::Emotion, expected);
+
+    BaselineStore store;
+    feedResting(store, 42, restingHeartRate, restingGsr, readings);
+    QCOMPARE(store.baseline(42).count, quint32(readings));
+    QCOMPARE(store.classify(*detector, 42, parameters), expected);
+}
+
+void TestEmotionDetector::testBaselineSnapshot()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filename = dir.filePath("baselines.bin");
+
+    BaselineStore store;
+    for (quint64 user = 0; user < 10000; ++user)
+        feedResting(store, user, 60 + user % 30, 4 + user % 5, 4);
+    QCOMPARE(store.size(), qsizetype(10000));
+    QVERIFY(store.memoryUsage() < 10000 * 96);
+    QCOMPARE(store.save(filename), QString());
+
+    BaselineStore restored;
+    QCOMPARE(restored.load(filename), QString());
+    QCOMPARE(restored.size(), store.size());
+    for (quint64 user : {quint64(0), quint64(1234), quint64(9999)}) {
+        QCOMPARE(restored.baseline(user).count, store.baseline(user).count);
+        QCOMPARE(restored.baseline(user).heartRateMean, store.baseline(user).heartRateMean);
+        QCOMPARE(restored.baseline(user).gsrDeviation, store.baseline(user).gsrDeviation);
+    }
+    QCOMPARE(restored.baseline(10000).count, quint32(0));
+
+    // Обновления после загрузки идут в память, в том числе с ростом таблицы
+    for (quint64 user = 10000; user < 20000; ++user)
+        restored.update(user, QVector<double>{70, 5, 36.6});
+    QCOMPARE(restored.size(), qsizetype(20000));
+    QCOMPARE(restored.baseline(1234).count, quint32(4));
+    QCOMPARE(restored.baseline(15000).count, quint32(1));
+
+    QVERIFY(!restored.load(dir.filePath("missing.bin")).isEmpty());
+    QCOMPARE(restored.size(), qsizetype(20000));
+}
+
+// Снимок в формате BaselineStore::save: заголовок и ячейки с заданными ключами
+static QByteArray snapshotBytes(quint64 capacity, quint64 size, const QList<quint64> &keys)
+{
+    QByteArray bytes(32 + keys.size() * 32, '\0');
+    const quint32 magic = 0x53424445;
+    const quint32 version = 1;
+    std::memcpy(bytes.data(), &magic, sizeof(magic));
+    std::memcpy(bytes.data() + 4, &version, sizeof(version));
+    std::memcpy(bytes.data() + 8, &capacity, sizeof(capacity));
+    std::memcpy(bytes.data() + 16, &size, sizeof(size));
+    for (qsizetype i = 0; i < keys.size(); ++i)
+        std::memcpy(bytes.data() + 32 * (i + 1), &keys.at(i), sizeof(quint64));
+    return bytes;
+}
+
+void TestEmotionDetector::testBaselineCorruptSnapshot_data()
+{
+    QTest::addColumn<QByteArray>("snapshot");
+    QTest::addColumn<bool>("valid");
+
+    QTest::newRow("valid") << snapshotBytes(4, 2, {0, 5, 0, 9}) << true;
+    // 2^59 ячеек по 32 байта дают 2^64: без проверки делением это 0 байт
+    QTest::newRow("capacity overflow") << snapshotBytes(quint64(1) << 59, 0, {}) << false;
+    QTest::newRow("capacity mismatch") << snapshotBytes(8, 2, {0, 5, 0, 9}) << false;
+    QTest::newRow("size over three quarters") << snapshotBytes(4, 4, {1, 2, 3, 4}) << false;
+    QTest::newRow("truncated slot") << snapshotBytes(4, 0, {0, 0, 0, 0}).chopped(1) << false;
+    // Таблица при загрузке не читается: такие снимки принимаются, но поиск
+    // и вставка на них должны завершаться
+    QTest::newRow("size mismatch") << snapshotBytes(4, 1, {0, 5, 0, 9}) << true;
+    QTest::newRow("no empty slot") << snapshotBytes(8, 0, {1, 2, 3, 4, 5, 6, 7, 8}) << true;
+}
+
+void TestEmotionDetector::testBaselineCorruptSnapshot()
+{
+    QFETCH(QByteArray, snapshot);
+    QFETCH(bool, valid);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filename = dir.filePath("baselines.bin");
+    QFile file(filename);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    QCOMPARE(file.write(snapshot), snapshot.size());
+    file.close();
+
+    BaselineStore store;
+    store.update(7, QVector<double>{70, 5, 36.6});
+    QCOMPARE(store.load(filename).isEmpty(), valid);
+    if (!valid) {
+        // После отказа прежние нормы на месте
+        QCOMPARE(store.size(), qsizetype(1));
+        QCOMPARE(store.baseline(7).count, quint32(1));
+    }
+    // Поиск и вставка отсутствующего ключа завершаются
+    QCOMPARE(store.baseline(12345).count, quint32(0));
+    store.update(12345, QVector<double>{70, 5, 36.6});
+    QCOMPARE(store.baseline(12345).count, quint32(1));
+}
+
+// Прямой подсчёт целых слов по всему тексту для сравнения с разбором по кускам
+static QList<qint64> countKeywords(const QString &text)
+{
+    static const QRegularExpression word(QStringLiteral("[\\p{L}\\p{N}\\p{M}]+(?:['\u2019][\\p{L}\\p{N}\\p{M}]+)*"));
+    const QList<EmotionDetector::TextKeyword> &keywords = EmotionDetector::textKeywords();
+    QList<qint64> counts(keywords.size(), 0);
+    for (QRegularExpressionMatchIterator it = word.globalMatch(text.toLower()); it.hasNext();) {
+        const QString token = it.next().captured();
+        for (qsizetype i = 0; i < keywords.size(); ++i) {
+            if (token == keywords.at(i).text)
+                ++counts[i];
+        }
+    }
+    return counts;
+}
+
+void TestEmotionDetector::testDocument_data()
+{
+    QTest::addColumn<QString>("text");
+    QTest::addColumn<int>("chunkSize");
+
+    QTest::newRow("empty") << "" << 4;
+    QTest::newRow("neutral") << "Just a regular day, nothing special." << 5;
+    QTest::newRow("words across chunks") << "happy xxhappyxx HAPPY happyxx joy" << 4;
+    QTest::newRow("priority") << "I hate mondays but love fridays" << 5;
+    QTest::newRow("negation across chunks") << "I am not really very happy, only sad" << 3;
+    QTest::newRow("no spaces") << "not-so-happy-but-never-sad-or-angry" << 4;
+    QTest::newRow("single characters") << "so wonderful and sad" << 1;
+    QTest::newRow("negation before long word") << "not " + QString(300, 'x') + " happy" << 7;
+    QTest::newRow("long gap after negation") << "never" + QString(300, ' ') + "sad" << 5;
+    QTest::newRow("unicode") << QString::fromUtf8("Радость \xF0\x9F\x98\x80 LONELY ночь \xF0\x9F\x98\x80" "angry") << 3;
+}
+
+void TestEmotionDetector::testDocument()
+{
+    QFETCH(QString, text);
+    QFETCH(int, chunkSize);
+
+    const DocumentAnalyzer::Result result = DocumentAnalyzer::analyzeText(text, true, chunkSize);
+    QCOMPARE(result.emotion, detector->analyzeText(text));
+    QCOMPARE(result.keywordCounts, countKeywords(text));
+    QCOMPARE(result.characters, qint64(text.size()));
+
+    qint64 offset = 0;
+    for (const DocumentAnalyzer::Section &section : result.sections) {
+        QCOMPARE(section.offset, offset);
+        offset += section.length;
+    }
+    QCOMPARE(offset, qint64(text.size()));
+}
+
+void TestEmotionDetector::testDocumentFile()
+{
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filename = dir.filePath("transcript.txt");
+
+    QString text;
+    for (int i = 0; i < 2000; ++i)
+        text += QString::fromUtf8("Мы были wonderful, но lonely\xF0\x9F\x98\x80 %1\n").arg(i);
+    text += "and then I was HAPPY";
+    {
+        QFile file(filename);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(text.toUtf8());
+    }
+
+    // Маленький буфер режет многобайтовые символы и слова на стыках.
+    // wonderful и lonely встречаются поровну, Excited раньше в списке.
+    const DocumentAnalyzer::Result result = DocumentAnalyzer::analyzeFile(filename, true, 16);
+    QVERIFY(result.error.isEmpty());
+    QCOMPARE(result.emotion, EmotionDetector::Excited);
+    QCOMPARE(result.emotion, detector->analyzeText(text));
+    QCOMPARE(result.keywordCounts, countKeywords(text));
+    QCOMPARE(result.characters, qint64(text.size()));
+    QVERIFY(result.sections.size() > 1);
+    QCOMPARE(result.sections.last().emotion, EmotionDetector::Happy);
+
+    QVERIFY(!DocumentAnalyzer::analyzeFile(dir.filePath("missing.txt")).error.isEmpty());
+}
+
+void TestEmotionDetector::testDocumentFileNoSeparators_data()
+{
+    QTest::addColumn<QByteArray>("prefix");
+    QTest::addColumn<int>("emotion");
+
+    QTest::newRow("plain") << QByteArray("I am ") << int(EmotionDetector::Happy);
+    // Отрицание перед длинным словом действует и после разреза внутри него
+    QTest::newRow("negated") << QByteArray("I am not ") << int(EmotionDetector::Neutral);
+}
+
+void TestEmotionDetector::testDocumentFileNoSeparators()
+{
+    QFETCH(QByteArray, prefix);
+    QFETCH(int, emotion);
+
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const QString filename = dir.filePath("dump.txt");
+
+    // Как base64 или шестнадцатеричный дамп: мегабайт без единого разделителя
+    const QByteArray run = QByteArray("QUJDRGhhcHB5").repeated(100000);
+    const QByteArray utf8 = prefix + run + " happy";
+    {
+        QFile file(filename);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        file.write(utf8);
+    }
+
+    const qsizetype bufferSize = 4096;
+    const DocumentAnalyzer::Result result = DocumentAnalyzer::analyzeFile(filename, false, bufferSize);
+    QVERIFY(result.error.isEmpty());
+    QCOMPARE(int(result.emotion), emotion);
+    QCOMPARE(result.emotion, detector->analyzeText(QString::fromUtf8(utf8)));
+    QCOMPARE(result.characters, qint64(utf8.size()));
+    // В памяти ждёт разбора не больше буфера с небольшим запасом
+    QVERIFY2(result.peakPending < 2 * bufferSize, qPrintable(QString::number(result.peakPending)));
+
+    QCOMPARE(DocumentAnalyzer::analyzeText(QString::fromUtf8(utf8), false, 1000).emotion, result.emotion);
+}
+
+void TestEmotionDetector::testSyntheticCorpus()
+{
+    QCOMPARE(SyntheticCorpus::messages(100, 0.1, 7), SyntheticCorpus::messages(100, 0.1, 7));
+    QVERIFY(SyntheticCorpus::messages(100, 0.1, 7) != SyntheticCorpus::messages(100, 0.1, 8));
+    QCOMPARE(SyntheticCorpus::sensorTrace(100, 7), SyntheticCorpus::sensorTrace(100, 7));
+
+    // Доля ключевых слов и средняя длина близки к заданным
+    QStringList keywords;
+    for (const EmotionDetector::TextKeyword &keyword : EmotionDetector::textKeywords())
+        keywords.append(keyword.text.toString());
+    qint64 words = 0;
+    qint64 matches = 0;
+    const QStringList messages = SyntheticCorpus::messages(5000, 0.1, 1, 12);
+    for (const QString &message : messages) {
+        for (const QString &word : message.toLower().split(' ')) {
+            ++words;
+            if (keywords.contains(QString(word).remove('.').remove('!')))
+                ++matches;
+        }
+    }
+    QVERIFY(qAbs(double(matches) / words - 0.1) < 0.01);
+    QVERIFY(qAbs(double(words) / messages.size() - 12) < 1);
+}
+
+// Калибровочные циклы, бюджеты считаются от их времени, поэтому не зависят
+// от машины. Показания — та же работа, что у анализатора, записанная
+// напрямую; текст — прежний поиск подстрок: копия в нижнем регистре и девять
+// проходов contains. Разбор на слова должен быть не медленнее.
+static EmotionDetector::Emotion calibrationText(const QString &text)
+{
+    static const QLatin1StringView keywords[] = {
+        QLatin1StringView("happy"), QLatin1StringView("joy"), QLatin1StringView("love"),
+        QLatin1StringView("excited"), QLatin1StringView("wonderful"),
+        QLatin1StringView("sad"), QLatin1StringView("lonely"),
+        QLatin1StringView("angry"), QLatin1StringView("hate")
+    };
+    static const EmotionDetector::Emotion emotions[] = {
+        EmotionDetector::Happy, EmotionDetector::Happy, EmotionDetector::Happy,
+        EmotionDetector::Excited, EmotionDetector::Excited,
+        EmotionDetector::Sad, EmotionDetector::Sad,
+        EmotionDetector::Angry, EmotionDetector::Angry
+    };
+
+    if (text.isEmpty()) return EmotionDetector::Neutral;
+
+    const QString lowerText = text.toLower();
+    for (int i = 0; i < int(std::size(keywords)); ++i) {
+        if (lowerText.contains(keywords[i]))
+            return emotions[i];
+    }
+    return EmotionDetector::Neutral;
+}
+
+static EmotionDetector::Emotion calibrationParameters(const QVector<double> &meters)
+{
+    if (meters.size() < 3) return EmotionDetector::Neutral;
+
+    const double heartRate = meters[0];
+    const double gsr = meters[1];
+
+    if (heartRate > 85 && gsr > 8) return EmotionDetector::Happy;
+    if (heartRate > 80 && gsr > 7) return EmotionDetector::Excited;
+    if (heartRate < 65 && gsr < 5) return EmotionDetector::Sad;
+    if (heartRate > 90 && gsr > 10) return EmotionDetector::Angry;
+
+    return EmotionDetector::Calm;
+}
+
+static EmotionDetector::Emotion calibrationCombined(const QString &text, const QVector<double> &meters)
+{
+    if (text.isEmpty()) return calibrationParameters(meters);
+    if (meters.isEmpty()) return calibrationText(text);
+
+    const EmotionDetector::Emotion textEmotion = calibrationText(text);
+    if (textEmotion != EmotionDetector::Neutral) return textEmotion;
+
+    return calibrationParameters(meters);
+}
+
+enum PerfOperation {
+    TextOperation,
+    Utf8Operation,
+    ParametersOperation,
+    CombinedOperation
+};
+
+struct PerfCorpus
+{
+    QStringList messages;
+    QList<QByteArray> utf8;
+    QList<QVector<double>> trace;
+};
+
+static PerfCorpus makePerfCorpus(int count, quint32 seed)
+{
+    PerfCorpus corpus;
+    corpus.messages = SyntheticCorpus::messages(count, 0.05, seed);
+    for (const QString &message : corpus.messages)
+        corpus.utf8.append(message.toUtf8());
+    corpus.trace = SyntheticCorpus::sensorTrace(count, seed + 1);
+    return corpus;
+}
+
+// Один проход по корпусу; сумма результатов не даёт компилятору выбросить вызовы
+template <typename Analyze>
+static int runCorpus(const PerfCorpus &corpus, Analyze analyze)
+{
+    int sum = 0;
+    for (qsizetype i = 0; i < corpus.messages.size(); ++i)
+        sum += analyze(i);
+    return sum;
+}
+
+static int runOperation(const EmotionDetector &detector, int operation, bool calibration, const PerfCorpus &corpus)
+{
+    const QStringList &messages = corpus.messages;
+    const QList<QByteArray> &utf8 = corpus.utf8;
+    const QList<QVector<double>> &trace = corpus.trace;
+    switch (operation) {
+    case TextOperation:
+        return calibration ? runCorpus(corpus, [&](qsizetype i) { return calibrationText(messages.at(i)); })
+                           : runCorpus(corpus, [&](qsizetype i) { return detector.analyzeText(messages.at(i)); });
+    case Utf8Operation:
+        // Без прямого пути байты пришлось бы сначала перевести в QString
+        return calibration ? runCorpus(corpus, [&](qsizetype i) { return calibrationText(QString::fromUtf8(utf8.at(i))); })
+                           : runCorpus(corpus, [&](qsizetype i) { return detector.analyzeUtf8(utf8.at(i)); });
+    case ParametersOperation:
+        return calibration ? runCorpus(corpus, [&](qsizetype i) { return calibrationParameters(trace.at(i)); })
+                           : runCorpus(corpus, [&](qsizetype i) { return detector.analyzeParameters(trace.at(i)); });
+    default:
+        return calibration ? runCorpus(corpus, [&](qsizetype i) { return calibrationCombined(messages.at(i), trace.at(i)); })
+                           : runCorpus(corpus, [&](qsizetype i) { return detector.combinedAnalysis(messages.at(i), trace.at(i)); });
+    }
+}
+
+void TestEmotionDetector::testPerformance_data()
+{
+    QTest::addColumn<int>("operation");
+    QTest::addColumn<int>("passes");
+    QTest::addColumn<double>("budget");
+
+    // Бюджет — допустимое отношение ко времени калибровки; вдвое более
+    // медленная версия его не проходит. Разбор показаний дешёвый, поэтому
+    // проходов по корпусу больше.
+    QTest::newRow("analyzeText") << int(TextOperation) << 1 << 1.0;
+    QTest::newRow("analyzeUtf8") << int(Utf8Operation) << 1 << 1.0;
+    QTest::newRow("analyzeParameters") << int(ParametersOperation) << 20 << 1.5;
+    QTest::newRow("combinedAnalysis") << int(CombinedOperation) << 1 << 1.0;
+}
+
+void TestEmotionDetector::testPerformance()
+{
+    QFETCH(int, operation);
+    QFETCH(int, passes);
+    QFETCH(double, budget);
+
+    if (qEnvironmentVariableIsSet("EMOTION_SKIP_PERF"))
+        QSKIP("Замеры отключены переменной EMOTION_SKIP_PERF");
+
+    const PerfCorpus corpus = makePerfCorpus(20000, 1);
+
+    // Замеры чередуются, берётся лучший из семи: так меньше влияют
+    // соседние процессы и смена частоты процессора
+    qint64 calibrationBest = std::numeric_limits<qint64>::max();
+    qint64 best = std::numeric_limits<qint64>::max();
+    volatile int sink = 0;
+    for (int round = 0; round < 7; ++round) {
+        QElapsedTimer timer;
+        timer.start();
+        for (int pass = 0; pass < passes; ++pass)
+            sink = sink + runOperation(*detector, operation, true, corpus);
+        calibrationBest = qMin(calibrationBest, timer.nsecsElapsed());
+
+        timer.restart();
+        for (int pass = 0; pass < passes; ++pass)
+            sink = sink + runOperation(*detector, operation, false, corpus);
+        best = qMin(best, timer.nsecsElapsed());
+    }
+
+    const double ratio = double(best) / qMax<qint64>(1, calibrationBest);
+    qInfo("%s: %.1f нс на вызов, %.2f от калибровки", QTest::currentDataTag(),
+          double(best) / (corpus.messages.size() * passes), ratio);
+    QVERIFY2(ratio <= budget, qPrintable(QString("%1 от калибровки при бюджете %2").arg(ratio, 0, 'f', 2).arg(budget)));
+}
+
+void TestEmotionDetector::testAllocations_data()
+{
+    QTest::addColumn<int>("operation");
+    QTest::addColumn<double>("budget");
+
+    // Разбор на слова и путь UTF-8 работают в буферах на стеке
+    QTest::newRow("analyzeText") << int(TextOperation) << 0.0;
+    QTest::newRow("analyzeUtf8") << int(Utf8Operation) << 0.0;
+    QTest::newRow("analyzeParameters") << int(ParametersOperation) << 0.0;
+    QTest::newRow("combinedAnalysis") << int(CombinedOperation) << 0.0;
+}
+
+void TestEmotionDetector::testAllocations()
+{
+    QFETCH(int, operation);
+    QFETCH(double, budget);
+
+    if (!AllocationCounter::isAvailable())
+        QSKIP("Подсчёт выделений памяти недоступен на этой платформе");
+
+    const PerfCorpus corpus = makePerfCorpus(2000, 3);
+    runOperation(*detector, operation, false, corpus);
+
+    const quint64 before = AllocationCounter::threadCount();
+    runOperation(*detector, operation, false, corpus);
+    const double perCall = double(AllocationCounter::threadCount() - before) / corpus.messages.size();
+    QVERIFY2(perCall <= budget, qPrintable(QString("%1 выделений на вызов при бюджете %2").arg(perCall).arg(budget)));
+}
+
+void TestEmotionDetector::testTimeline_data()
+{
+    QTest::addColumn<qint64>("from");
+    QTest::addColumn<qint64>("to");
+    QTest::addColumn<quint64>("total");
+    QTest::addColumn<quint32>("happy");
+
+    // Два часа по показанию в секунду, каждое третье — Happy
+    QTest::newRow("last minute") << qint64(7140000) << qint64(7200000) << quint64(60) << quint32(20);
+    QTest::newRow("whole session") << qint64(0) << qint64(7200000) << quint64(7200) << quint32(2400);
+    QTest::newRow("rounded to second") << qint64(7140100) << qint64(7140200) << quint64(1) << quint32(1);
+    QTest::newRow("seconds and minutes") << qint64(6000000) << qint64(6660000) << quint64(660) << quint32(220);
+    QTest::newRow("future") << qint64(8000000) << qint64(9000000) << quint64(0) << quint32(0);
+    QTest::newRow("empty range") << qint64(7000000) << qint64(7000000) << quint64(0) << quint32(0);
+}
+
+void TestEmotionDetector::testTimeline()
+{
+    QFETCH(qint64, from);
+    QFETCH(qint64, to);
+    QFETCH(quint64, total);
+    QFETCH(quint32, happy);
+
+    EmotionTimeline timeline;
+    for (qint64 second = 0; second < 7200; ++second)
+        timeline.add(second % 3 == 0 ? EmotionDetector::Happy : EmotionDetector::Calm, second * 1000 + 500);
+
+    const EmotionTimeline::Histogram histogram = timeline.distribution(from, to);
+    QCOMPARE(EmotionTimeline::total(histogram), total);
+    QCOMPARE(histogram[EmotionDetector::Happy], happy);
+}
+
+void TestEmotionDetector::testTimelineRetention()
+{
+    EmotionTimeline timeline;
+    const qsizetype memory = timeline.memoryUsage();
+
+    for (qint64 second = 0; second < 120; ++second)
+        timeline.add(EmotionDetector::Sad, second * 1000);
+    // В сыром виде остаётся только последняя минута
+    QCOMPARE(timeline.recent(0).size(), qsizetype(61));
+    QCOMPARE(timeline.recent(100000).size(), qsizetype(20));
+
+    // Через десять дней первые показания уже за пределами почасовой истории
+    const qint64 later = 10LL * 24 * 3600 * 1000;
+    for (qint64 minute = 0; minute < 600; ++minute)
+        timeline.add(EmotionDetector::Happy, later + minute * 60000);
+    QCOMPARE(EmotionTimeline::total(timeline.distribution(0, 3600000)), quint64(0));
+    QCOMPARE(timeline.distribution(later, later + 36000000)[EmotionDetector::Happy], quint32(600));
+    QCOMPARE(timeline.memoryUsage(), memory);
+
+    timeline.clear();
+    QCOMPARE(EmotionTimeline::total(timeline.distribution(0, later * 2)), quint64(0));
+    QVERIFY(timeline.recent(0).isEmpty());
+}
+
+void TestEmotionDetector::testUtf8_data()
+{
+    QTest::addColumn<QByteArray>("utf8");
+
+    QTest::newRow("empty") << QByteArray();
+    QTest::newRow("ascii") << QByteArray("I'm SO Happy today!");
+    QTest::newRow("neutral") << QByteArray("Just a regular day, nothing special.");
+    QTest::newRow("cyrillic around") << QByteArray("Сегодня я LONELY и грустный");
+    QTest::newRow("dotted capital i") << QByteArray("\xC4\xB0stanbul was WONDERFUL");
+    QTest::newRow("invalid bytes") << QByteArray("\xFF\xC3 ha\xE0\x80te and ANGRY");
+    QTest::newRow("across blocks") << QByteArray(4093, 'x') + " HATE";
+    QTest::newRow("negation across blocks") << QByteArray(4090, 'x') + " not HAPPY";
+    QTest::newRow("long word across blocks") << QByteArray(5000, 'x') + "hate";
+    QTest::newRow("long contraction") << QByteArray("I WOULDN\xE2\x80\x99T be sad but HAPPY");
+    QTest::newRow("long non-ascii") << QByteArray("Ж").repeated(3000) + "JOY";
+}
+
+void TestEmotionDetector::testUtf8()
+{
+    QFETCH(QByteArray, utf8);
+
+    QCOMPARE(detector->analyzeUtf8(utf8), detector->analyzeText(QString::fromUtf8(utf8)));
+    if (utf8.isValidUtf8())
+        QCOMPARE(Utf8Lexicon::toLower(utf8), QString::fromUtf8(utf8).toLower().toUtf8());
+}
+
+void TestEmotionDetector::testUtf8Cyrillic()
+{
+    const Utf8Lexicon lexicon({{EmotionDetector::Happy, QStringView(u"Радость")},
+                               {EmotionDetector::Sad, QStringView(u"грусть")}});
+
+    QCOMPARE(lexicon.analyze(QByteArray("Большая РАДОСТЬ!")), EmotionDetector::Happy);
+    QCOMPARE(lexicon.analyze(QByteArray("ГрУсТь и радость")), EmotionDetector::Happy);
+    QCOMPARE(lexicon.analyze(QByteArray("Лёгкая ГРУСТЬ")), EmotionDetector::Sad);
+    QCOMPARE(lexicon.analyze(QByteArray("happy")), EmotionDetector::Neutral);
+}
+
+void TestEmotionDetector::testDifferential_data()
+{
+    QTest::addColumn<QByteArray>("input");
+
+    const QList<QByteArray> inputs = DifferentialCheck::adversarialInputs();
+    for (qsizetype i = 0; i < inputs.size(); ++i)
+        QTest::addRow("adversarial %lld", qlonglong(i)) << inputs.at(i);
+}
+
+void TestEmotionDetector::testDifferential()
+{
+    QFETCH(QByteArray, input);
+
+    DifferentialCheck check(*detector);
+    const QStringList mismatches = check.run(input);
+    QVERIFY2(mismatches.isEmpty(), qPrintable(mismatches.join("; ")));
+}
+
+void TestEmotionDetector::testDifferentialRandom()
+{
+    // Тот же seed — те же входы; долгий поиск — в EmotionDetectionFuzz
+    DifferentialCheck check(*detector);
+    QRandomGenerator random(49);
+    for (int i = 0; i < 3000; ++i) {
+        const QByteArray input = DifferentialCheck::randomInput(random);
+        const QStringList mismatches = check.run(input);
+        QVERIFY2(mismatches.isEmpty(), qPrintable(QString("вход %1: %2").arg(i).arg(mismatches.join("; "))));
+    }
+}
+
+void TestEmotionDetector::testAsync_data()
+{
+    QTest::addColumn<int>("priority");
+
+    QTest::newRow("interactive") << int(EmotionDetector::Interactive);
+    QTest::newRow("bulk") << int(EmotionDetector::Bulk);
+}
+
+void TestEmotionDetector::testAsync()
+{
+    QFETCH(int, priority);
+
+    const PerfCorpus corpus = makePerfCorpus(200, 4);
+    const auto kind = EmotionDetector::Priority(priority);
+    QList<QFuture<EmotionDetector::Emotion>> futures;
+    for (qsizetype i = 0; i < corpus.messages.size(); ++i) {
+        futures.append(detector->analyzeTextAsync(corpus.messages.at(i), kind));
+        futures.append(detector->analyzeUtf8Async(corpus.utf8.at(i), kind));
+        futures.append(detector->analyzeParametersAsync(corpus.trace.at(i), kind));
+        futures.append(detector->combinedAnalysisAsync(corpus.messages.at(i), corpus.trace.at(i), kind));
+    }
+    for (qsizetype i = 0; i < corpus.messages.size(); ++i) {
+        const QString &message = corpus.messages.at(i);
+        QCOMPARE(futures.at(4 * i).result(), detector->analyzeText(message));
+        QCOMPARE(futures.at(4 * i + 1).result(), detector->analyzeText(message));
+        QCOMPARE(futures.at(4 * i + 2).result(), detector->analyzeParameters(corpus.trace.at(i)));
+        QCOMPARE(futures.at(4 * i + 3).result(), detector->combinedAnalysis(message, corpus.trace.at(i)));
+    }
+}
+
+void TestEmotionDetector::testAsyncCancel()
+{
+    // Один фоновый поток, занятый задачей, которая ждёт semaphore:
+    // остальные фоновые задачи гарантированно стоят в очереди
+    QSemaphore started;
+    QSemaphore release;
+    auto scheduler = std::make_unique<AnalysisScheduler>(2);
+    QCOMPARE(scheduler->bulkSlots(), 1);
+    const QFuture<EmotionDetector::Emotion> running = scheduler->submit(EmotionDetector::Bulk, [&] {
+        started.release();
+        release.acquire();
+        return EmotionDetector::Happy;
+    });
+    started.acquire();
+
+    // Поток с циклом событий, из которого задачи ставятся, как из интерфейса
+    QThread submitter;
+    submitter.start();
+    QObject context;
+    context.moveToThread(&submitter);
+    // При провале проверки пул не должен остаться ждать semaphore
+    const auto cleanup = qScopeGuard([&] {
+        release.release();
+        submitter.quit();
+        submitter.wait();
+    });
+
+    QList<QFuture<EmotionDetector::Emotion>> queued;
+    for (int i = 0; i < 4; ++i)
+        queued.append(scheduler->submit(EmotionDetector::Bulk, [] { return EmotionDetector::Sad; }));
+    QFuture<EmotionDetector::Emotion> watched;
+    QMetaObject::invokeMethod(&context, [&] {
+        watched = scheduler->submit(EmotionDetector::Bulk, [] { return EmotionDetector::Sad; });
+    }, Qt::BlockingQueuedConnection);
+    QCOMPARE(scheduler->queuedBulk(), 5);
+
+    // Задача, поставленная из потока с циклом событий, после отмены сразу
+    // убирается из очереди и завершается, не дожидаясь задач перед ней
+    watched.cancel();
+    QElapsedTimer waiting;
+    waiting.start();
+    while (!watched.isFinished() && waiting.elapsed() < 5000)
+        QThread::msleep(1);
+    QVERIFY(watched.isFinished());
+    QVERIFY(watched.isCanceled());
+    QCOMPARE(watched.resultCount(), 0);
+    QVERIFY(!running.isFinished());
+    QCOMPARE(scheduler->queuedBulk(), 4);
+
+    // Без цикла событий отменённая задача ждёт, пока до неё дойдёт черёд,
+    // но не выполняется (проверяется ниже)
+    queued[1].cancel();
+    QVERIFY(queued.at(1).isCanceled());
+
+    // Интерактивный запрос проходит, пока фоновый поток занят
+    const QFuture<EmotionDetector::Emotion> interactive = scheduler->submit(EmotionDetector::Interactive, [] { return EmotionDetector::Angry; });
+    QCOMPARE(interactive.result(), EmotionDetector::Angry);
+    QVERIFY(!running.isFinished());
+    QVERIFY(!queued.at(0).isFinished());
+
+    // Удаление отменяет очередь сразу, а выполняющуюся задачу ждёт
+    std::thread destroyer([&] { scheduler.reset(); });
+    QElapsedTimer timer;
+    timer.start();
+    while (!queued.at(0).isCanceled() && timer.elapsed() < 5000)
+        QThread::msleep(1);
+    const bool canceledWhileRunning = queued.at(0).isCanceled() && !running.isFinished();
+    release.release();
+    destroyer.join();
+
+    QVERIFY(canceledWhileRunning);
+    QCOMPARE(running.result(), EmotionDetector::Happy);
+    for (const QFuture<EmotionDetector::Emotion> &future : std::as_const(queued)) {
+        QVERIFY(future.isFinished());
+        QVERIFY(future.isCanceled());
+        QCOMPARE(future.resultCount(), 0);
+    }
+
+    // Пул детектора, созданный при первом асинхронном разборе
+    const EmotionDetector lazy;
+    QCOMPARE(lazy.analyzeTextAsync("so happy", EmotionDetector::Bulk).result(), EmotionDetector::Happy);
+}
+
+void TestEmotionDetector::testAsyncLatency()
+{
+    if (qEnvironmentVariableIsSet("EMOTION_SKIP_PERF"))
+        QSKIP("Замеры отключены переменной EMOTION_SKIP_PERF");
+    if (QThread::idealThreadCount() < 2)
+        QSKIP("Для замера нужно хотя бы два ядра");
+
+    // Фоновая задача — длинный документ, интерактивная — короткое сообщение
+    EmotionDetector loaded;
+    const QString document = SyntheticCorpus::messages(5000, 0.05, 5).join(' ');
+    const QStringList messages = SyntheticCorpus::messages(500, 0.05, 6);
+
+    qint64 bulkJob = std::numeric_limits<qint64>::max();
+    for (int round = 0; round < 5; ++round) {
+        QElapsedTimer timer;
+        timer.start();
+        loaded.analyzeText(document);
+        bulkJob = qMin(bulkJob, timer.nsecsElapsed());
+    }
+
+    QList<QFuture<EmotionDetector::Emotion>> bulk;
+    for (int i = 0; i < 200 * QThread::idealThreadCount(); ++i)
+        bulk.append(loaded.analyzeTextAsync(document, EmotionDetector::Bulk));
+
+    QList<qint64> latencies;
+    QList<EmotionDetector::Emotion> results;
+    for (const QString &message : messages) {
+        QElapsedTimer timer;
+        timer.start();
+        const QFuture<EmotionDetector::Emotion> future = loaded.analyzeTextAsync(message);
+        results.append(future.result());
+        latencies.append(timer.nsecsElapsed());
+    }
+    const bool stillLoaded = !bulk.last().isFinished();
+    for (QFuture<EmotionDetector::Emotion> &future : bulk)
+        future.cancel();
+
+    for (qsizetype i = 0; i < messages.size(); ++i)
+        QCOMPARE(results.at(i), loaded.analyzeText(messages.at(i)));
+
+    std::sort(latencies.begin(), latencies.end());
+    const qint64 p50 = latencies.at(latencies.size() / 2);
+    const qint64 p99 = latencies.at(latencies.size() * 99 / 100);
+    qInfo("интерактивные запросы под фоновой нагрузкой: p50 %.3f мс, p99 %.3f мс; фоновая задача %.3f мс",
+          p50 / 1e6, p99 / 1e6, bulkJob / 1e6);
+    QVERIFY2(stillLoaded, "Фоновая очередь опустела раньше конца замера");
+    // В общей очереди запрос ждал бы все фоновые задачи перед ним,
+    // без свободного потока — хотя бы одну
+    QVERIFY2(p99 < bulkJob, qPrintable(QString("p99 %1 мс при фоновой задаче %2 мс").arg(p99 / 1e6).arg(bulkJob / 1e6)));
+}
+
 QTEST_APPLESS_MAIN(TestEmotionDetector)
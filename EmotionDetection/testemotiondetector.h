@@ -3,7 +3,16 @@
 
 #include <QObject>
 #include <QtTest/QtTest>
+#include "allocationcounter.h"
+#include "analysisscheduler.h"
+#include "baselinestore.h"
+#include "differentialcheck.h"
+#include "documentanalyzer.h"
 #include "emotiondetector.h"
+#include "emotiontimeline.h"
+#include "emotiontracker.h"
+#include "syntheticcorpus.h"
+#include "utf8lexicon.h"
 
 class TestEmotionDetector : public QObject
 {
@@ -24,6 +33,45 @@ private slots:
 
     void testEmotionToString();
 
+    void testTracker_data();
+    void testTracker();
+    void testTrackerText();
+
+    void testBaseline_data();
+    void testBaseline();
+    void testBaselineSnapshot();
+    void testBaselineCorruptSnapshot_data();
+    void testBaselineCorruptSnapshot();
+
+    void testDocument_data();
+    void testDocument();
+    void testDocumentFile();
+    void testDocumentFileNoSeparators_data();
+    void testDocumentFileNoSeparators();
+
+    void testSyntheticCorpus();
+    void testPerformance_data();
+    void testPerformance();
+    void testAllocations_data();
+    void testAllocations();
+
+    void testTimeline_data();
+    void testTimeline();
+    void testTimelineRetention();
+
+    void testUtf8_data();
+    void testUtf8();
+    void testUtf8Cyrillic();
+
+    void testDifferential_data();
+    void testDifferential();
+    void testDifferentialRandom();
+
+    void testAsync_data();
+    void testAsync();
+    void testAsyncCancel();
+    void testAsyncLatency();
+
 private:
     EmotionDetector *detector;
 };
@@ -0,0 +1,175 @@
+#include "utf8lexicon.h"
+#include <QtEndian>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+const qsizetype BlockSize = 4096;
+// Самый длинный результат для одного символа не из ASCII
+const qsizetype MaxFoldedChar = 4;
+const quint64 HighBits = 0x8080808080808080ULL;
+
+// Строчные ASCII-буквы в восьми байтах сразу; байты от 0x80 не меняются
+quint64 lowerAscii8(quint64 word)
+{
+    const quint64 heptets = word & ~HighBits;
+    const quint64 fromA = heptets + 0x3f3f3f3f3f3f3f3fULL;  // старший бит, если байт >= 'A'
+    const quint64 afterZ = heptets + 0x2525252525252525ULL; // старший бит, если байт > 'Z'
+    const quint64 upper = (fromA ^ afterZ) & ~word & HighBits;
+    return word | (upper >> 2);
+}
+
+// Обрабатывает ASCII до первого байта от 0x80 или до size; возвращает число байт
+qsizetype lowerAsciiRun(const char *in, qsizetype size, char *out)
+{
+    qsizetype i = 0;
+#ifdef __SSE2__
+    const __m128i beforeA = _mm_set1_epi8('A' - 1);
+    const __m128i afterZ = _mm_set1_epi8('Z' + 1);
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    for (; size - i >= 16; i += 16) {
+        // Байты от 0x80 отрицательны и в диапазон 'A'..'Z' не попадают
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+        const __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(bytes, beforeA), _mm_cmplt_epi8(bytes, afterZ));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + i), _mm_or_si128(bytes, _mm_and_si128(upper, caseBit)));
+        const int nonAscii = _mm_movemask_epi8(bytes);
+        if (nonAscii)
+            return i + qCountTrailingZeroBits(quint32(nonAscii));
+    }
+#endif
+    for (; size - i >= 8; i += 8) {
+        const quint64 word = qFromLittleEndian<quint64>(in + i);
+        qToLittleEndian(lowerAscii8(word), out + i);
+        const quint64 nonAscii = word & HighBits;
+        if (nonAscii)
+            return i + qCountTrailingZeroBits(nonAscii) / 8;
+    }
+    for (; i < size; ++i) {
+        const uchar byte = uchar(in[i]);
+        if (byte >= 0x80)
+            return i;
+        out[i] = char(byte >= 'A' && byte <= 'Z' ? byte | 0x20 : byte);
+    }
+    return i;
+}
+
+// Один символ UTF-8; неверная последовательность даёт U+FFFD длиной в байт
+char32_t decodeUtf8(const uchar *in, const uchar *end, qsizetype &length)
+{
+    length = 1;
+    const uchar lead = in[0];
+    qsizetype need;
+    char32_t code;
+    uchar low = 0x80;
+    uchar high = 0xbf;
+    if (lead >= 0xc2 && lead <= 0xdf) {
+        need = 1;
+        code = lead & 0x1f;
+    } else if (lead >= 0xe0 && lead <= 0xef) {
+        need = 2;
+        code = lead & 0x0f;
+        if (lead == 0xe0)
+            low = 0xa0;
+        else if (lead == 0xed)
+            high = 0x9f;
+    } else if (lead >= 0xf0 && lead <= 0xf4) {
+        need = 3;
+        code = lead & 0x07;
+        if (lead == 0xf0)
+            low = 0x90;
+        else if (lead == 0xf4)
+            high = 0x8f;
+    } else {
+        return 0xfffd;
+    }
+
+    if (end - in <= need)
+        return 0xfffd;
+    for (qsizetype i = 1; i <= need; ++i) {
+        if (in[i] < low || in[i] > high)
+            return 0xfffd;
+        low = 0x80;
+        high = 0xbf;
+        code = (code << 6) | (in[i] & 0x3f);
+    }
+    length = need + 1;
+    return code;
+}
+
+char *appendUtf8(char *out, char32_t code)
+{
+    if (code < 0x80) {
+        *out++ = char(code);
+    } else if (code < 0x800) {
+        *out++ = char(0xc0 | (code >> 6));
+        *out++ = char(0x80 | (code & 0x3f));
+    } else if (code < 0x10000) {
+        *out++ = char(0xe0 | (code >> 12));
+        *out++ = char(0x80 | ((code >> 6) & 0x3f));
+        *out++ = char(0x80 | (code & 0x3f));
+    } else {
+        *out++ = char(0xf0 | (code >> 18));
+        *out++ = char(0x80 | ((code >> 12) & 0x3f));
+        *out++ = char(0x80 | ((code >> 6) & 0x3f));
+        *out++ = char(0x80 | (code & 0x3f));
+    }
+    return out;
+}
+
+}
+
+Utf8Lexicon::Utf8Lexicon(const QList<EmotionDetector::TextKeyword> &keywords)
+    : scanner(keywords)
+{
+}
+
+EmotionDetector::Emotion Utf8Lexicon::analyze(QByteArrayView text) const
+{
+    // Слово на стыке блоков собирается в проходе, перекрывать блоки не нужно
+    WordScanner::Pass pass(scanner);
+    char buffer[BlockSize];
+    const char *in = text.data();
+    const char *const end = in + text.size();
+    while (in < end)
+        WordScanner::scanLowered(QByteArrayView(buffer, foldBlock(in, end, buffer, buffer + BlockSize)), pass);
+    pass.finish();
+    return pass.emotion();
+}
+
+QByteArray Utf8Lexicon::toLower(QByteArrayView text)
+{
+    QByteArray result;
+    char buffer[BlockSize];
+    const char *in = text.data();
+    const char *const end = in + text.size();
+    while (in < end)
+        result.append(buffer, foldBlock(in, end, buffer, buffer + BlockSize));
+    return result;
+}
+
+qsizetype Utf8Lexicon::foldBlock(const char *&in, const char *end, char *out, char *outEnd)
+{
+    char *const start = out;
+    while (in < end && outEnd - out >= MaxFoldedChar) {
+        const qsizetype ascii = lowerAsciiRun(in, qMin(end - in, outEnd - out), out);
+        in += ascii;
+        out += ascii;
+        if (in == end || outEnd - out < MaxFoldedChar || uchar(*in) < 0x80)
+            continue;
+
+        // Полные правила Unicode только для символов не из ASCII; особый
+        // случай — İ, которая, как и в QString::toLower, даёт два символа
+        qsizetype length;
+        const char32_t code = decodeUtf8(reinterpret_cast<const uchar *>(in), reinterpret_cast<const uchar *>(end), length);
+        in += length;
+        if (code == 0x130) {
+            out = appendUtf8(out, U'i');
+            out = appendUtf8(out, 0x307);
+        } else {
+            out = appendUtf8(out, QChar::toLower(code));
+        }
+    }
+    return out - start;
+}
@@ -0,0 +1,30 @@
+#ifndef UTF8LEXICON_H
+#define UTF8LEXICON_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QList>
+#include "emotiondetector.h"
+#include "wordscanner.h"
+
+// Разбор текста прямо в байтах UTF-8. Текст приводится к нижнему регистру
+// блоками в буфер на стеке: ASCII по 16 байт за раз (SSE2) или по 8 (SWAR),
+// остальные символы по одному через таблицы Unicode. Слова из блока идут в
+// WordScanner, поэтому результат совпадает с разбором QString::fromUtf8(text).
+class Utf8Lexicon
+{
+public:
+    explicit Utf8Lexicon(const QList<EmotionDetector::TextKeyword> &keywords);
+
+    EmotionDetector::Emotion analyze(QByteArrayView text) const;
+
+    static QByteArray toLower(QByteArrayView text);
+
+private:
+    WordScanner scanner;
+
+    // Переводит байты из in в out, пока хватает места; сдвигает in
+    static qsizetype foldBlock(const char *&in, const char *end, char *out, char *outEnd);
+};
+
+#endif // UTF8LEXICON_H
@@ -0,0 +1,399 @@
+#include "wordscanner.h"
+#include <cstring>
+
+namespace {
+
+enum CharClass : quint8 {
+    Separator,
+    WordChar,
+    ApostropheChar,
+    ClauseEnd
+};
+
+constexpr std::array<quint8, 128> makeAsciiClasses()
+{
+    std::array<quint8, 128> classes = {};
+    for (int c = '0'; c <= '9'; ++c)
+        classes[c] = WordChar;
+    for (int c = 'A'; c <= 'Z'; ++c)
+        classes[c] = WordChar;
+    for (int c = 'a'; c <= 'z'; ++c)
+        classes[c] = WordChar;
+    classes['\''] = ApostropheChar;
+    for (char c : {'.', ',', ';', ':', '!', '?'})
+        classes[uchar(c)] = ClauseEnd;
+    return classes;
+}
+
+constexpr std::array<quint8, 128> AsciiClasses = makeAsciiClasses();
+
+const char *const Negators[] = {"not", "no", "never", "cannot"};
+const char *const Intensifiers[] = {"very", "so", "really", "extremely", "totally", "truly"};
+
+inline CharClass classOf(char32_t code)
+{
+    if (code < 0x80)
+        return CharClass(AsciiClasses[code]);
+    if (code == 0x2019)
+        return ApostropheChar;
+    if (QChar::isLetterOrNumber(code) || QChar::isMark(code))
+        return WordChar;
+    return Separator;
+}
+
+// Символ, который заканчивается на позиции end; одиночный суррогат — сам по себе
+char32_t codeBefore(QStringView text, qsizetype end, qsizetype &length)
+{
+    const char16_t unit = text.utf16()[end - 1];
+    if (QChar::isLowSurrogate(unit) && end >= 2 && QChar::isHighSurrogate(text.utf16()[end - 2])) {
+        length = 2;
+        return QChar::surrogateToUcs4(text.utf16()[end - 2], unit);
+    }
+    length = 1;
+    return unit;
+}
+
+// Сокращённые отрицания: "don't", "isn’t", "shouldn’t"
+inline bool isContraction(QByteArrayView word)
+{
+    return word.endsWith("n't") || word.endsWith("n\xE2\x80\x99t");
+}
+
+// Следующий символ text с позиции i в нижнем регистре
+inline void addLowered(const char16_t *data, qsizetype &i, qsizetype size, WordScanner::Pass &pass)
+{
+    char32_t code = data[i++];
+    if (code < 0x80) {
+        pass.add(code - U'A' < 26 ? code | 0x20 : code);
+        return;
+    }
+    if (QChar::isHighSurrogate(code) && i < size && QChar::isLowSurrogate(data[i]))
+        code = QChar::surrogateToUcs4(char16_t(code), data[i++]);
+    // Как в QString::toLower, İ даёт два символа
+    if (code == 0x130) {
+        pass.add(U'i');
+        pass.add(0x307);
+    } else {
+        pass.add(QChar::toLower(code));
+    }
+}
+
+// Сокращает текст без концов фраз так, что проход по нему оставляет то же
+// окно и то же начало незаконченного слова: слово длиннее limit символов
+// становится словом из limit + 1 букв "x" и своего конца, промежуток между
+// словами — пробелом
+class Compactor
+{
+public:
+    explicit Compactor(qsizetype limit) : limit(limit) {}
+
+    void add(QStringView text)
+    {
+        for (qsizetype i = 0; i < text.size();) {
+            const qsizetype from = i;
+            qsizetype length;
+            const CharClass kind = classOf(codeAt(text, i, length));
+            i += length;
+            if (kind == WordChar) {
+                if (apostrophe) {
+                    appendWord(QStringView(&apostrophe, 1));
+                    apostrophe = 0;
+                }
+                appendWord(text.sliced(from, length));
+            } else if (kind == ApostropheChar && runLength > 0 && !apostrophe) {
+                apostrophe = text.at(from).unicode();
+            } else {
+                endRun();
+                apostrophe = 0;
+                if (!separator)
+                    result += u' ';
+                separator = true;
+            }
+        }
+    }
+
+    QString finish()
+    {
+        endRun();
+        // Апостроф на самом конце может соединить слово с продолжением
+        if (apostrophe)
+            result += QChar(apostrophe);
+        return result;
+    }
+
+private:
+    // Символов UTF-16 в конце длинного слова: не меньше TailBytes байт,
+    // даже если первый окажется половиной суррогатной пары
+    static constexpr qsizetype TailUnits = WordScanner::TailBytes + 1;
+
+    const qsizetype limit;
+    QString result;
+    QString tail;
+    qsizetype runLength = 0;
+    char16_t apostrophe = 0;
+    bool separator = false;
+
+    static char32_t codeAt(QStringView text, qsizetype i, qsizetype &length)
+    {
+        const char16_t unit = text.utf16()[i];
+        if (QChar::isHighSurrogate(unit) && i + 1 < text.size() && QChar::isLowSurrogate(text.utf16()[i + 1])) {
+            length = 2;
+            return QChar::surrogateToUcs4(unit, text.utf16()[i + 1]);
+        }
+        length = 1;
+        return unit;
+    }
+
+    void appendWord(QStringView units)
+    {
+        separator = false;
+        if (runLength > limit) {
+            tail += units;
+        } else {
+            result += units;
+            runLength += units.size();
+            if (runLength <= limit)
+                return;
+            tail = result.right(TailUnits);
+            result.chop(runLength);
+            result += QString(limit + 1, u'x');
+            runLength = limit + 1;
+        }
+        if (tail.size() > TailUnits)
+            tail.remove(0, tail.size() - TailUnits);
+    }
+
+    void endRun()
+    {
+        if (runLength > limit) {
+            if (tail.front().isLowSurrogate())
+                tail.remove(0, 1);
+            result += tail;
+            tail.clear();
+        }
+        runLength = 0;
+    }
+};
+
+}
+
+WordScanner::WordScanner(const QList<EmotionDetector::TextKeyword> &keywords)
+{
+    for (const EmotionDetector::TextKeyword &keyword : keywords) {
+        addEntry(keyword.text.toString().toLower().toUtf8(), int(keywordEmotions.size()));
+        keywordEmotions.append(keyword.emotion);
+        if (!priority.contains(keyword.emotion))
+            priority.append(keyword.emotion);
+    }
+    for (const char *negator : Negators)
+        addEntry(negator, Negator);
+    for (const char *intensifier : Intensifiers)
+        addEntry(intensifier, Intensifier);
+}
+
+void WordScanner::addEntry(const QByteArray &text, int kind)
+{
+    Q_ASSERT(!text.isEmpty() && text.size() <= MaxWordBytes);
+    entries.append(Entry{text, kind});
+    lengths |= quint64(1) << text.size();
+    longest = qMax(longest, text.size());
+}
+
+int WordScanner::classify(QByteArrayView word) const
+{
+    const qsizetype size = word.size();
+    if (size == 0 || size > longest)
+        return OtherWord;
+    // Большинство слов отсекается по длине без единого сравнения
+    if (lengths & (quint64(1) << size)) {
+        for (const Entry &entry : entries) {
+            if (entry.text.size() == size && entry.text.front() == word.front()
+                && std::memcmp(entry.text.constData(), word.data(), size_t(size)) == 0)
+                return entry.kind;
+        }
+    }
+    return isContraction(word) ? Negator : OtherWord;
+}
+
+EmotionDetector::Emotion WordScanner::emotion(const Scores &scores) const
+{
+    EmotionDetector::Emotion best = EmotionDetector::Neutral;
+    qint64 bestScore = 0;
+    for (EmotionDetector::Emotion candidate : priority) {
+        if (scores[candidate] > bestScore) {
+            best = candidate;
+            bestScore = scores[candidate];
+        }
+    }
+    return best;
+}
+
+void WordScanner::scan(QStringView text, qsizetype begin, qsizetype end, Pass &pass)
+{
+    const char16_t *data = text.utf16();
+    const qsizetype size = text.size();
+    for (qsizetype i = begin; i < size;) {
+        if (!pass.inWord()) {
+            if (i >= end)
+                return;
+            pass.setCounting(true);
+        }
+        addLowered(data, i, size, pass);
+    }
+    pass.finish();
+}
+
+void WordScanner::scanContext(QStringView context, Pass &pass)
+{
+    pass.setCounting(false);
+    const char16_t *data = context.utf16();
+    for (qsizetype i = 0; i < context.size();)
+        addLowered(data, i, context.size(), pass);
+}
+
+void WordScanner::scanLowered(QByteArrayView text, Pass &pass)
+{
+    const uchar *in = reinterpret_cast<const uchar *>(text.data());
+    const uchar *const end = in + text.size();
+    while (in < end) {
+        const uchar lead = *in++;
+        if (lead < 0x80) {
+            pass.add(lead);
+            continue;
+        }
+        // Текст уже прошёл через декодер, последовательности в нём верные
+        int need = lead >= 0xf0 ? 3 : lead >= 0xe0 ? 2 : 1;
+        char32_t code = lead & (0x3f >> need);
+        for (; need > 0 && in < end; --need)
+            code = (code << 6) | (*in++ & 0x3f);
+        pass.add(code);
+    }
+}
+
+QString WordScanner::context(QStringView previous, QStringView text) const
+{
+    // Назад по тем же правилам до конца фразы или пока не наберётся
+    // Window + 1 слов: первое может быть разрезано концом text. Начинать
+    // можно только после разделителя, на апострофе слово могло продолжаться.
+    int words = 0;
+    bool inWord = false;
+    const auto walk = [&](QStringView part) -> qsizetype {
+        for (qsizetype i = part.size(); i > 0;) {
+            qsizetype length;
+            const CharClass kind = classOf(codeBefore(part, i, length));
+            if (kind == WordChar) {
+                inWord = true;
+            } else if (kind != ApostropheChar) {
+                if (inWord)
+                    ++words;
+                inWord = false;
+                if (kind == ClauseEnd || words > Window)
+                    return i;
+            }
+            i -= length;
+        }
+        return -1;
+    };
+
+    Compactor compactor(longest + 1);
+    const qsizetype start = walk(text);
+    if (start >= 0) {
+        compactor.add(text.sliced(start));
+    } else {
+        // previous сам начинается с начала текста, конца фразы или разделителя
+        compactor.add(previous.sliced(qMax<qsizetype>(walk(previous), 0)));
+        compactor.add(text);
+    }
+    return compactor.finish();
+}
+
+WordScanner::Pass::Pass(const WordScanner &scanner, qint64 *counts)
+    : scanner(scanner), counts(counts)
+{
+}
+
+void WordScanner::Pass::add(char32_t code)
+{
+    const CharClass kind = classOf(code);
+    if (kind == WordChar) {
+        if (apostrophe) {
+            append(apostrophe);
+            apostrophe = 0;
+        }
+        append(code);
+        return;
+    }
+    if (inWord()) {
+        if (kind == ApostropheChar && !apostrophe) {
+            apostrophe = code;
+            return;
+        }
+        endWord();
+    }
+    if (kind == ClauseEnd) {
+        sinceNegator = Window;
+        sinceIntensifier = Window;
+    }
+}
+
+void WordScanner::Pass::finish()
+{
+    if (inWord())
+        endWord();
+}
+
+void WordScanner::Pass::append(char32_t code)
+{
+    char bytes[4];
+    qsizetype size;
+    if (code < 0x80) {
+        bytes[0] = char(code);
+        size = 1;
+    } else if (code < 0x800) {
+        bytes[0] = char(0xc0 | (code >> 6));
+        bytes[1] = char(0x80 | (code & 0x3f));
+        size = 2;
+    } else if (code < 0x10000) {
+        bytes[0] = char(0xe0 | (code >> 12));
+        bytes[1] = char(0x80 | ((code >> 6) & 0x3f));
+        bytes[2] = char(0x80 | (code & 0x3f));
+        size = 3;
+    } else {
+        bytes[0] = char(0xf0 | (code >> 18));
+        bytes[1] = char(0x80 | ((code >> 12) & 0x3f));
+        bytes[2] = char(0x80 | ((code >> 6) & 0x3f));
+        bytes[3] = char(0x80 | (code & 0x3f));
+        size = 4;
+    }
+    // Длиннее самого длинного значимого слова: ключевым оно уже не будет,
+    // но ещё может оказаться сокращённым отрицанием, поэтому при
+    // заполнении буфера остаётся только конец
+    if (length + size > scanner.longest)
+        overlong = true;
+    if (length + size > MaxWordBytes) {
+        std::memmove(word, word + length - TailBytes, size_t(TailBytes));
+        length = TailBytes;
+    }
+    std::memcpy(word + length, bytes, size_t(size));
+    length += size;
+}
+
+void WordScanner::Pass::endWord()
+{
+    const QByteArrayView text(word, length);
+    const int kind = overlong ? (isContraction(text) ? Negator : OtherWord) : scanner.classify(text);
+    if (kind >= 0 && counting) {
+        qint64 weight = sinceIntensifier < Window ? 2 : 1;
+        if (sinceNegator < Window)
+            weight = -weight;
+        values[scanner.keywordEmotions.at(kind)] += weight;
+        if (counts)
+            ++counts[kind];
+    }
+    sinceNegator = kind == Negator ? 0 : qMin(sinceNegator + 1, Window);
+    sinceIntensifier = kind == Intensifier ? 0 : qMin(sinceIntensifier + 1, Window);
+
+    length = 0;
+    apostrophe = 0;
+    overlong = false;
+}
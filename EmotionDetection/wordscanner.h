@@ -0,0 +1,118 @@
+#ifndef WORDSCANNER_H
+#define WORDSCANNER_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QList>
+#include <QString>
+#include <QStringView>
+#include <array>
+#include "emotiondetector.h"
+
+// Разбор текста на слова за один проход без возвратов. Слово — непрерывная
+// последовательность букв, цифр и диакритических знаков; одиночный апостроф
+// между буквами его не разрывает ("don't"). Ключевое слово засчитывается
+// только целиком: "sad" не находится в "crusade".
+//
+// Окно из трёх предыдущих слов хранится счётчиками: отрицание ("not",
+// "never", "...n't") в окне меняет знак веса ключевого слова, усилитель
+// ("very", "so") удваивает его. Знаки .,;:!? окно сбрасывают. Итог — эмоция
+// с наибольшим положительным счётом, при равенстве та, что раньше в списке.
+class WordScanner
+{
+public:
+    static constexpr int Window = 3;
+    static constexpr int EmotionCount = EmotionDetector::Surprise + 1;
+    // Буфер слова: ключевые слова и модификаторы не длиннее стольких байт UTF-8
+    static constexpr qsizetype MaxWordBytes = 48;
+    // Сколько последних байт длинного слова хранится: хватает на "n’t"
+    static constexpr qsizetype TailBytes = 5;
+    using Scores = std::array<qint64, EmotionCount>;
+
+    // Значение classify для слов, которые не являются ключевыми
+    enum WordKind {
+        OtherWord = -1,
+        Negator = -2,
+        Intensifier = -3
+    };
+
+    // Один проход по тексту: слово, которое сейчас собирается, окно и счёт.
+    // Живёт на стеке и памяти не выделяет.
+    class Pass
+    {
+    public:
+        // counts, если задан, получает число вхождений каждого ключевого слова
+        explicit Pass(const WordScanner &scanner, qint64 *counts = nullptr);
+
+        // Следующий символ, уже в нижнем регистре
+        void add(char32_t code);
+        // Конец текста: дописывает последнее слово
+        void finish();
+
+        bool inWord() const { return length > 0 || overlong; }
+        // Засчитывать ли слово, которое начнётся со следующего символа;
+        // незасчитанные слова только сдвигают окно
+        void setCounting(bool value) { counting = value; }
+
+        const Scores &scores() const { return values; }
+        EmotionDetector::Emotion emotion() const { return scanner.emotion(values); }
+
+    private:
+        const WordScanner &scanner;
+        qint64 *counts;
+        Scores values = {};
+        int sinceNegator = Window;
+        int sinceIntensifier = Window;
+        bool counting = true;
+        // У слова длиннее значимых хранится только конец, TailBytes байт
+        bool overlong = false;
+        char32_t apostrophe = 0;
+        qsizetype length = 0;
+        char word[MaxWordBytes];
+
+        void append(char32_t code);
+        void endWord();
+    };
+
+    explicit WordScanner(const QList<EmotionDetector::TextKeyword> &keywords);
+
+    // Номер ключевого слова в списке или WordKind; слово в UTF-8 и нижнем регистре
+    int classify(QByteArrayView word) const;
+    qsizetype keywordCount() const { return keywordEmotions.size(); }
+    // Самое длинное значимое слово в байтах UTF-8, а значит и в символах UTF-16
+    qsizetype longestWord() const { return longest; }
+    EmotionDetector::Emotion emotion(const Scores &scores) const;
+
+    // Проходит text с begin; засчитываются слова с началом в [begin, end),
+    // последнее может заходить за end. Окно к begin задаёт scanContext.
+    static void scan(QStringView text, qsizetype begin, qsizetype end, Pass &pass);
+    // Текст перед куском: только заполняет окно и начинает слово, которое
+    // продолжится в куске
+    static void scanContext(QStringView context, Pass &pass);
+    // Кусок UTF-8 в нижнем регистре, без разорванных символов; слово может
+    // продолжиться в следующем куске
+    static void scanLowered(QByteArrayView text, Pass &pass);
+    // Короткий текст, который для scanContext равноценен всему тексту до
+    // конца text: несколько последних слов, длинные слова и промежутки
+    // сокращены. previous — такой же контекст перед text. Длина результата
+    // ограничена независимо от длины слов и text.
+    QString context(QStringView previous, QStringView text) const;
+
+private:
+    struct Entry
+    {
+        QByteArray text;
+        int kind;
+    };
+
+    QList<Entry> entries;
+    QList<EmotionDetector::Emotion> keywordEmotions;
+    // Эмоции в порядке первого появления в списке слов
+    QList<EmotionDetector::Emotion> priority;
+    quint64 lengths = 0;
+    qsizetype longest = 0;
+
+    void addEntry(const QByteArray &text, int kind);
+};
+
+#endif // WORDSCANNER_H
@@ -0,0 +1,61 @@
+#include "aggregateresultmodel.h"
+
+AggregateResultModel::AggregateResultModel(QObject *parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+int AggregateResultModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(groups.size());
+}
+
+int AggregateResultModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant AggregateResultModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid())
+        return QVariant();
+
+    if (role == Qt::TextAlignmentRole && index.column() != KeyColumn)
+        return int(Qt::AlignRight | Qt::AlignVCenter);
+    if (role != Qt::DisplayRole)
+        return QVariant();
+
+    const CallAggregator::Group &group = groups.at(index.row());
+    switch (index.column()) {
+    case KeyColumn: return group.key;
+    case CountColumn: return group.count;
+    case SumColumn: return group.sum;
+    case AverageColumn: return QString::number(group.average(), 'f', 1);
+    case MinColumn: return group.min;
+    case MaxColumn: return group.max;
+    default: return QVariant();
+    }
+}
+
+QVariant AggregateResultModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal)
+        return QAbstractTableModel::headerData(section, orientation, role);
+
+    switch (section) {
+    case KeyColumn: return "Группа";
+    case CountColumn: return "Звонков";
+    case SumColumn: return "Всего, мин";
+    case AverageColumn: return "Среднее, мин";
+    case MinColumn: return "Мин.";
+    case MaxColumn: return "Макс.";
+    default: return QVariant();
+    }
+}
+
+void AggregateResultModel::setGroups(const QList<CallAggregator::Group> &groups)
+{
+    beginResetModel();
+    this->groups = groups;
+    endResetModel();
+}
@@ -0,0 +1,35 @@
+#ifndef AGGREGATERESULTMODEL_H
+#define AGGREGATERESULTMODEL_H
+
+#include <QAbstractTableModel>
+#include "callaggregator.h"
+
+class AggregateResultModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        KeyColumn,
+        CountColumn,
+        SumColumn,
+        AverageColumn,
+        MinColumn,
+        MaxColumn,
+        ColumnCount
+    };
+
+    explicit AggregateResultModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    void setGroups(const QList<CallAggregator::Group> &groups);
+
+private:
+    QList<CallAggregator::Group> groups;
+};
+
+#endif // AGGREGATERESULTMODEL_H
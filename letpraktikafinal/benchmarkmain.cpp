@@ -0,0 +1,87 @@
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSysInfo>
+#include <QTemporaryDir>
+#include <QThread>
+#include <cstdio>
+#include "callbenchmark.h"
+
+int main(int argc, char *argv[])
+{
+    // Окна не нужны, поэтому по умолчанию работаем без дисплея
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    QApplication a(argc, argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Замеры операций с таблицей звонков, результат в JSON");
+    parser.addHelpOption();
+    QCommandLineOption rowsOption("rows", "Размеры наборов через запятую (до 10000000).", "list", "10000,100000,1000000");
+    QCommandLineOption seedOption("seed", "Начальное значение генератора.", "number", "20240701");
+    QCommandLineOption repeatOption("repeat", "Число повторов каждой операции.", "count", "3");
+    QCommandLineOption outputOption({"o", "output"}, "Файл для результатов (по умолчанию stdout).", "file");
+    QCommandLineOption checkOption("check", "Число случайных полей для сверки разбора времени и IP (0 — только граничные случаи).", "count", "1000000");
+    parser.addOptions({rowsOption, seedOption, repeatOption, outputOption, checkOption});
+    parser.process(a);
+
+    QList<int> sizes;
+    for (const QString &text : parser.value(rowsOption).split(',', Qt::SkipEmptyParts)) {
+        bool ok = false;
+        const int rows = text.trimmed().toInt(&ok);
+        if (!ok || rows <= 0 || rows > 10000000) {
+            std::fprintf(stderr, "Неверный размер набора: %s\n", qPrintable(text));
+            return 1;
+        }
+        sizes.append(rows);
+    }
+    const quint32 seed = parser.value(seedOption).toUInt();
+    const int repeat = qMax(1, parser.value(repeatOption).toInt());
+    const int checkInputs = qMax(0, parser.value(checkOption).toInt());
+
+    // Замеры быстрого разбора имеют смысл, только если он не расходится с простым
+    std::fprintf(stderr, "Сверка разбора времени и IP...\n");
+    const QStringList mismatches = CallBenchmark::checkParsers(seed, checkInputs);
+    if (!mismatches.isEmpty()) {
+        for (const QString &mismatch : mismatches)
+            std::fprintf(stderr, "%s\n", qPrintable(mismatch));
+        return 1;
+    }
+
+    QTemporaryDir workDir;
+    if (!workDir.isValid()) {
+        std::fprintf(stderr, "Не удалось создать временный каталог\n");
+        return 1;
+    }
+
+    QJsonArray results;
+    for (int rows : sizes) {
+        std::fprintf(stderr, "%d записей...\n", rows);
+        results.append(CallBenchmark::run(rows, seed, repeat, workDir.path()));
+    }
+
+    QJsonObject report;
+    report["benchmark"] = "letpraktikafinal";
+    report["qt_version"] = qVersion();
+    report["platform"] = QSysInfo::prettyProductName();
+    report["cpu"] = QSysInfo::currentCpuArchitecture();
+    report["threads"] = QThread::idealThreadCount();
+    report["seed"] = double(seed);
+    report["repeat"] = repeat;
+    report["parser_check_inputs"] = checkInputs;
+    report["results"] = results;
+    const QByteArray json = QJsonDocument(report).toJson();
+
+    if (!parser.isSet(outputOption)) {
+        std::fwrite(json.constData(), 1, size_t(json.size()), stdout);
+        return 0;
+    }
+    QFile output(parser.value(outputOption));
+    if (!output.open(QIODevice::WriteOnly | QIODevice::Truncate) || output.write(json) != json.size()) {
+        std::fprintf(stderr, "Не удалось записать %s\n", qPrintable(output.fileName()));
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include "callaggregator.h"
+#include "perfmonitor.h"
+#include <QFuture>
+#include <QHash>
+#include <QtConcurrent>
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+struct Accumulator
+{
+    qint64 sum = 0;
+    qint64 count = 0;
+    qint32 min = std::numeric_limits<qint32>::max();
+    qint32 max = std::numeric_limits<qint32>::min();
+
+    void add(qint32 value)
+    {
+        sum += value;
+        ++count;
+        min = qMin(min, value);
+        max = qMax(max, value);
+    }
+
+    void merge(const Accumulator &other)
+    {
+        sum += other.sum;
+        count += other.count;
+        min = qMin(min, other.min);
+        max = qMax(max, other.max);
+    }
+};
+
+template <typename Key, typename KeyOf>
+QHash<Key, Accumulator> aggregateParallel(const CallRecordColumns &columns, KeyOf keyOf)
+{
+    QList<QFuture<QHash<Key, Accumulator>>> futures;
+    for (const QPair<int, int> &range : CallRecord::partitions(columns.size())) {
+        futures.append(QtConcurrent::run([&columns, keyOf, range]() {
+            QHash<Key, Accumulator> partial;
+            for (int row = range.first; row < range.second; ++row) {
+                const qint32 duration = columns.durations.at(row);
+                Key key;
+                if (duration != CallRecord::InvalidDuration && keyOf(row, key))
+                    partial[key].add(duration);
+            }
+            return partial;
+        }));
+    }
+
+    QHash<Key, Accumulator> total;
+    for (QFuture<QHash<Key, Accumulator>> &future : futures) {
+        const QHash<Key, Accumulator> partial = future.result();
+        if (total.isEmpty()) {
+            total = partial;
+            continue;
+        }
+        for (auto it = partial.cbegin(); it != partial.cend(); ++it)
+            total[it.key()].merge(it.value());
+    }
+    return total;
+}
+
+CallAggregator::Group makeGroup(const QString &key, const Accumulator &accumulator)
+{
+    CallAggregator::Group group;
+    group.key = key;
+    group.sum = accumulator.sum;
+    group.count = accumulator.count;
+    group.min = accumulator.min;
+    group.max = accumulator.max;
+    return group;
+}
+
+}
+
+QList<CallAggregator::Group> CallAggregator::aggregate(const CallRecordColumns &columns, GroupBy groupBy, int prefixLength)
+{
+    PerfMonitor::Scope scope("aggregate", columns.size());
+    QList<Group> groups;
+
+    if (groupBy == BySurname) {
+        // Группировка по номерам фамилий; строки достаются из словаря один раз на группу
+        const QHash<quint32, Accumulator> totals = aggregateParallel<quint32>(columns, [&columns](int row, quint32 &key) {
+            key = columns.surnameIds.at(row);
+            return true;
+        });
+        const SurnameDictionary &dictionary = SurnameDictionary::shared();
+        groups.reserve(totals.size());
+        for (auto it = totals.cbegin(); it != totals.cend(); ++it)
+            groups.append(makeGroup(dictionary.text(it.key()), it.value()));
+        std::sort(groups.begin(), groups.end(), [](const Group &a, const Group &b) {
+            return a.key < b.key;
+        });
+        return groups;
+    }
+
+    const int bits = groupBy == ByIp ? 32 : qBound(0, prefixLength, 32);
+    const quint32 mask = bits == 0 ? 0 : ~quint32(0) << (32 - bits);
+    const QHash<quint32, Accumulator> totals = aggregateParallel<quint32>(columns, [&columns, mask](int row, quint32 &key) {
+        const quint32 ip = columns.ips.at(row);
+        if (ip == CallRecord::InvalidIp)
+            return false;
+        key = ip & mask;
+        return true;
+    });
+
+    QList<quint32> keys = totals.keys();
+    std::sort(keys.begin(), keys.end());
+    groups.reserve(keys.size());
+    for (quint32 key : keys) {
+        QString label = CallRecord::formatIpv4(key);
+        if (groupBy == BySubnet)
+            label += QString("/%1").arg(bits);
+        groups.append(makeGroup(label, totals.value(key)));
+    }
+    return groups;
+}
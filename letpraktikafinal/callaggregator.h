@@ -0,0 +1,34 @@
+#ifndef CALLAGGREGATOR_H
+#define CALLAGGREGATOR_H
+
+#include <QList>
+#include <QString>
+#include "callrecord.h"
+
+class CallAggregator
+{
+public:
+    enum GroupBy {
+        BySurname,
+        ByIp,
+        BySubnet
+    };
+
+    struct Group
+    {
+        QString key;
+        qint64 sum = 0;
+        qint64 count = 0;
+        qint32 min = 0;
+        qint32 max = 0;
+
+        double average() const { return count > 0 ? double(sum) / double(count) : 0.0; }
+    };
+
+    // Группировка по хешу: каждый диапазон строк считается в своём потоке,
+    // затем частичные результаты сливаются. Строки-ключи формируются
+    // только для итоговых групп.
+    static QList<Group> aggregate(const CallRecordColumns &columns, GroupBy groupBy, int prefixLength = 24);
+};
+
+#endif // CALLAGGREGATOR_H
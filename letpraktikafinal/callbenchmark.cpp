@@ -0,0 +1,338 @@
+#include "callbenchmark.h"
+#include "callrecordimporter.h"
+#include "callrecordmodel.h"
+#include "callrecordwriter.h"
+#include "callsummarymodel.h"
+#include "perfmonitor.h"
+#include "surnamelistmodel.h"
+#include <QComboBox>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QListView>
+#include <QRandomGenerator>
+#include <QtConcurrent>
+#include <algorithm>
+
+namespace {
+
+const char *const SurnameRoots[] = {
+    "Иван", "Петр", "Сидор", "Смирн", "Кузнецов", "Попов", "Васильев", "Соколов",
+    "Михайл", "Новик", "Федор", "Морозов", "Волк", "Алексеев", "Лебедев", "Семен",
+    "Егор", "Павл", "Козл", "Степан", "Николаев", "Орл", "Андреев", "Макар",
+    "Никит", "Захар", "Зайцев", "Солов", "Борис", "Яковлев", "Григорьев", "Роман",
+    "Воробь", "Серг", "Кузьмин", "Фрол", "Александр", "Дмитриев", "Королев", "Гусев"
+};
+const char *const SurnameSuffixes[] = {"ов", "ова", "ин", "ина", "енко", "ский", "ская", "ич"};
+
+constexpr int BatchSize = 4096;
+constexpr int MaxMismatches = 20;
+
+void appendGeneratedRecord(QByteArray &out, QRandomGenerator &random)
+{
+    // Квадрат равномерной величины: частые фамилии встречаются заметно чаще редких
+    const int roots = int(std::size(SurnameRoots));
+    const quint32 pick = random.bounded(quint32(roots * roots));
+    out += SurnameRoots[pick * pick / quint32(roots * roots * roots)];
+    out += SurnameSuffixes[random.bounded(int(std::size(SurnameSuffixes)))];
+    out += ',';
+
+    // Короткие звонки преобладают, длинные встречаются реже
+    const int scale = random.bounded(4);
+    out += QByteArray::number(random.bounded(1 << (2 * scale + 2)));
+    out += ',';
+
+    if (random.bounded(20) == 0) {
+        out += "192.168.";
+        out += QByteArray::number(random.bounded(4));
+    } else {
+        out += "10.";
+        out += QByteArray::number(random.bounded(16));
+    }
+    out += '.';
+    out += QByteArray::number(random.bounded(256));
+    out += '.';
+    out += QByteArray::number(1 + random.bounded(254));
+    out += '\n';
+}
+
+// Эталон для checkParsers: правила из callrecord.h, разбор по одному символу
+qint32 referenceDuration(QByteArrayView text)
+{
+    text = text.trimmed();
+    if (text.isEmpty() || text.size() > 8)
+        return CallRecord::InvalidDuration;
+    qint32 value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9')
+            return CallRecord::InvalidDuration;
+        value = value * 10 + (c - '0');
+    }
+    return value;
+}
+
+quint32 referenceIpv4(QByteArrayView text)
+{
+    const QList<QByteArray> parts = text.trimmed().toByteArray().split('.');
+    if (parts.size() != 4)
+        return CallRecord::InvalidIp;
+    quint32 ip = 0;
+    for (const QByteArray &part : parts) {
+        if (part.isEmpty() || part.size() > 3 || (part.size() > 1 && part.front() == '0'))
+            return CallRecord::InvalidIp;
+        quint32 value = 0;
+        for (char c : part) {
+            if (c < '0' || c > '9')
+                return CallRecord::InvalidIp;
+            value = value * 10 + quint32(c - '0');
+        }
+        if (value > 255)
+            return CallRecord::InvalidIp;
+        ip = (ip << 8) | value;
+    }
+    return ip;
+}
+
+// Поле для сообщения: непечатные байты в виде \xHH
+QString describe(const QByteArray &field)
+{
+    QString out;
+    for (char c : field) {
+        if (c >= 0x20 && c < 0x7F)
+            out += QLatin1Char(c);
+        else
+            out += QString("\\x%1").arg(uchar(c), 2, 16, QLatin1Char('0'));
+    }
+    return '"' + out + '"';
+}
+
+// Случайное поле из символов, которые встречаются в этих полях и рядом с ними
+QByteArray randomField(QRandomGenerator &random)
+{
+    static const char Alphabet[] = "0123456789.. \t-x";
+    QByteArray out;
+    const int length = random.bounded(18);
+    for (int i = 0; i < length; ++i)
+        out += Alphabet[random.bounded(int(sizeof(Alphabet)) - 1)];
+    return out;
+}
+
+// Случайный адрес, похожий на настоящий: октеты до 300, иногда с ведущими
+// нулями и пробелами по краям, иногда с одним испорченным байтом
+QByteArray randomAddress(QRandomGenerator &random)
+{
+    QByteArray out;
+    for (int octet = 0; octet < 4; ++octet) {
+        if (octet > 0)
+            out += '.';
+        if (random.bounded(8) == 0)
+            out += '0';
+        out += QByteArray::number(random.bounded(301));
+    }
+    if (random.bounded(4) == 0)
+        out = " " + out + "\t";
+    if (random.bounded(8) == 0)
+        out[random.bounded(int(out.size()))] = "0.9 "[random.bounded(4)];
+    return out;
+}
+
+}
+
+QByteArray CallBenchmark::generate(int rows, quint32 seed)
+{
+    QRandomGenerator random(seed);
+    QByteArray out;
+    out.reserve(qsizetype(rows) * 32);
+    for (int row = 0; row < rows; ++row)
+        appendGeneratedRecord(out, random);
+    return out;
+}
+
+QJsonObject CallBenchmark::measure(int rows, int repeat, const std::function<void()> &prepare, const std::function<void()> &operation)
+{
+    QList<qint64> times;
+    for (int i = 0; i < repeat; ++i) {
+        if (prepare)
+            prepare();
+        QElapsedTimer timer;
+        timer.start();
+        operation();
+        times.append(timer.nsecsElapsed());
+    }
+    std::sort(times.begin(), times.end());
+
+    const double best = double(times.first()) / 1e6;
+    QJsonObject result;
+    result["ms_min"] = best;
+    result["ms_median"] = double(times.at(times.size() / 2)) / 1e6;
+    result["rows_per_s"] = best > 0 ? double(rows) * 1000.0 / best : 0.0;
+    return result;
+}
+
+QJsonObject CallBenchmark::run(int rows, quint32 seed, int repeat, const QString &workDir)
+{
+    QJsonObject operations;
+    const QString inputPath = QDir(workDir).filePath(QString("calls-%1.txt").arg(rows));
+    const QString outputPath = QDir(workDir).filePath(QString("saved-%1.txt").arg(rows));
+
+    QByteArray text;
+    operations["generate"] = measure(rows, repeat, nullptr, [&]() {
+        text = generate(rows, seed);
+    });
+    const qint64 fileBytes = text.size();
+    {
+        QFile file(inputPath);
+        if (!file.open(QIODevice::WriteOnly) || file.write(text) != fileBytes)
+            qFatal("Не удалось записать %s", qPrintable(inputPath));
+    }
+
+    // Разбор в одном потоке, без чтения файла
+    CallRecordColumns records;
+    operations["parse"] = measure(rows, repeat, [&]() { records = CallRecordColumns(); }, [&]() {
+        CallRecordRejects rejects;
+        records.appendLines(text, rejects);
+    });
+    text = QByteArray();
+    records = CallRecordColumns();
+
+    const qint64 memoryBefore = PerfMonitor::residentMemory();
+    operations["load"] = measure(rows, repeat, [&]() { records = CallRecordColumns(); }, [&]() {
+        records = CallRecordImporter::importFiles({inputPath}).records;
+    });
+    // Для разбора важнее пропускная способность в байтах
+    for (const char *name : {"parse", "load"}) {
+        QJsonObject operation = operations[name].toObject();
+        const double ms = operation["ms_min"].toDouble();
+        operation["mb_per_s"] = ms > 0 ? double(fileBytes) / 1e6 * 1000.0 / ms : 0.0;
+        operations[name] = operation;
+    }
+
+    CallRecordModel model;
+    operations["insert"] = measure(rows, repeat, [&]() { model.setColumns(CallRecordColumns()); }, [&]() {
+        model.setColumns(records);
+    });
+    const qint64 memoryAfter = PerfMonitor::residentMemory();
+
+    QList<CallRecordColumns> batches;
+    for (int first = 0; first < records.size(); first += BatchSize) {
+        CallRecordColumns batch;
+        const int last = qMin(records.size(), first + BatchSize);
+        batch.reserve(last - first);
+        for (int row = first; row < last; ++row)
+            batch.appendRow(records, row);
+        batches.append(batch);
+    }
+    operations["append"] = measure(rows, repeat, [&]() { model.setColumns(CallRecordColumns()); }, [&]() {
+        for (const CallRecordColumns &batch : batches)
+            model.appendRecords(batch);
+    });
+    batches.clear();
+    model.setColumns(records);
+
+    const auto unsorted = [&]() { model.sortBy({}); };
+    operations["sort_surname"] = measure(rows, repeat, unsorted, [&]() {
+        model.sortBy({{CallRecordModel::LastNameColumn, Qt::AscendingOrder}});
+    });
+    operations["sort_duration_ip"] = measure(rows, repeat, unsorted, [&]() {
+        model.sortBy({{CallRecordModel::DurationColumn, Qt::DescendingOrder},
+                      {CallRecordModel::IpColumn, Qt::AscendingOrder}});
+    });
+    model.sortBy({});
+
+    // Удаление каждой десятой строки одним пакетом
+    QList<int> removed;
+    for (int row = 0; row < rows; row += 10)
+        removed.append(row);
+    operations["bulk_delete"] = measure(int(removed.size()), repeat, [&]() { model.setColumns(records); }, [&]() {
+        model.applyChanges(removed);
+    });
+    model.setColumns(records);
+
+    // Обновление выпадающего списка и списка записей — как в MainWindow
+    QComboBox comboBox;
+    SurnameListModel comboModel(&model);
+    comboBox.setModel(&comboModel);
+    comboBox.setSizeAdjustPolicy(QComboBox::AdjustToMinimumContentsLengthWithIcon);
+    operations["combo_refresh"] = measure(rows, repeat, nullptr, [&]() {
+        comboModel.refresh();
+    });
+
+    QListView listView;
+    CallSummaryModel summaryModel(&model);
+    listView.setModel(&summaryModel);
+    listView.setUniformItemSizes(true);
+    listView.resize(400, 600);
+    operations["list_refresh"] = measure(rows, repeat, nullptr, [&]() {
+        summaryModel.refresh();
+        // Отрисовка видимой части: форматируются только показанные строки
+        listView.grab();
+    });
+
+    operations["save"] = measure(rows, repeat, nullptr, [&]() {
+        const QString error = QtConcurrent::run(&CallRecordWriter::save, model.columns(), outputPath).result();
+        if (!error.isEmpty())
+            qFatal("Не удалось сохранить %s: %s", qPrintable(outputPath), qPrintable(error));
+    });
+
+    QFile::remove(inputPath);
+    QFile::remove(outputPath);
+
+    QJsonObject memory;
+    memory["rss_bytes"] = double(memoryAfter);
+    memory["rss_delta_bytes"] = double(memoryAfter - memoryBefore);
+    memory["surname_index_bytes"] = double(model.surnameIndex().memoryUsage());
+    memory["surname_dictionary_bytes"] = double(SurnameDictionary::shared().memoryUsage());
+
+    QJsonObject result;
+    result["rows"] = rows;
+    result["file_bytes"] = double(fileBytes);
+    result["operations"] = operations;
+    result["memory"] = memory;
+    return result;
+}
+
+QStringList CallBenchmark::checkParsers(quint32 seed, int randomInputs)
+{
+    QStringList mismatches;
+    const auto check = [&](const QByteArray &field) {
+        if (mismatches.size() >= MaxMismatches)
+            return;
+        const qint32 duration = CallRecord::parseDuration(field);
+        const qint32 expectedDuration = referenceDuration(field);
+        if (duration != expectedDuration)
+            mismatches.append(QString("parseDuration(%1) = %2, ожидалось %3").arg(describe(field)).arg(duration).arg(expectedDuration));
+        const quint32 ip = CallRecord::parseIpv4(field);
+        const quint32 expectedIp = referenceIpv4(field);
+        if (ip != expectedIp)
+            mismatches.append(QString("parseIpv4(%1) = %2, ожидалось %3").arg(describe(field)).arg(ip).arg(expectedIp));
+
+        // Разбор из QString совпадает с разбором байтов, пока поле в ASCII
+        if (std::any_of(field.begin(), field.end(), [](char c) { return uchar(c) >= 0x80; }))
+            return;
+        const QString text = QString::fromLatin1(field);
+        if (CallRecord::parseDuration(QStringView(text)) != expectedDuration)
+            mismatches.append(QString("parseDuration(QString %1) расходится с разбором байтов").arg(describe(field)));
+        if (CallRecord::parseIpv4(QStringView(text)) != expectedIp)
+            mismatches.append(QString("parseIpv4(QString %1) расходится с разбором байтов").arg(describe(field)));
+    };
+
+    static const char *const EdgeCases[] = {
+        "", " ", "\t\r\n", "0", "00", "007", "00000000", "000000000", "  42 ", "\t42\r\n",
+        "12345678", "99999999", "123456789", "100000000", "999999999", " 12345678 ", " 123456789 ",
+        "-1", "+1", "1 2", "1e3", "4a", "\xD9\xA3", "5\xC2\xA0",
+        "0.0.0.0", "1.2.3.4", "01.2.3.4", "1.2.3.04", "1.02.3.4", "00.1.1.1", "0000.1.1.1",
+        "1.2.3.0", "10.0.0.1", " 10.0.0.1 ", "\t10.0.0.1\n", "256", "256.1.1.1", "1.1.1.256",
+        "1.1.1.300", "999.1.1.1", "255.255.255.254", "255.255.255.255", " 255.255.255.255 ",
+        "100.100.100.100", "192.168.100.200", "255.255.255.2555", "1.2.3", "1.2.3.4.5", "1..2.3",
+        "1.2.3.", ".1.2.3", "...", "10.0.0.1x", "10.0.0.-1", "10.0.0. 1", "1.2.3.4 5", "1.2.3.4\x80"
+    };
+    for (const char *field : EdgeCases)
+        check(QByteArray(field));
+
+    QRandomGenerator random(seed);
+    for (int i = 0; i < randomInputs && mismatches.size() < MaxMismatches; ++i) {
+        check(randomField(random));
+        check(randomAddress(random));
+    }
+    return mismatches;
+}
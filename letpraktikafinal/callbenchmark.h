@@ -0,0 +1,29 @@
+#ifndef CALLBENCHMARK_H
+#define CALLBENCHMARK_H
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+#include <functional>
+
+class CallBenchmark
+{
+public:
+    // Синтетический журнал "Фамилия,Время,IP": при одном и том же seed
+    // содержимое совпадает байт в байт, поэтому прогоны разных версий сравнимы
+    static QByteArray generate(int rows, quint32 seed);
+
+    // Прогон всех операций на rows записях; каждая повторяется repeat раз,
+    // в отчёт идут минимум и медиана. Временные файлы пишутся в workDir.
+    static QJsonObject run(int rows, quint32 seed, int repeat, const QString &workDir);
+
+    // Сверка SWAR-разбора времени и IPv4 с простым посимвольным разбором:
+    // граничные случаи и randomInputs случайных полей. Возвращает расхождения.
+    static QStringList checkParsers(quint32 seed, int randomInputs);
+
+private:
+    static QJsonObject measure(int rows, int repeat, const std::function<void()> &prepare, const std::function<void()> &operation);
+};
+
+#endif // CALLBENCHMARK_H
@@ -0,0 +1,155 @@
+#include "calllogfollower.h"
+#include <QFile>
+
+namespace {
+
+constexpr int FlushInterval = 100;
+// Запасной опрос на случай, если файловая система не присылает уведомлений
+constexpr int PollInterval = 1000;
+// Больше за один заход не читается: разбор такой порции занимает миллисекунды
+constexpr qint64 ReadChunk = 1024 * 1024;
+constexpr qsizetype FingerprintSize = 256;
+
+}
+
+CallLogFollower::CallLogFollower(QObject *parent)
+    : QObject(parent)
+{
+    watcher = new QFileSystemWatcher(this);
+    connect(watcher, &QFileSystemWatcher::fileChanged, this, &CallLogFollower::readNewData);
+
+    pollTimer = new QTimer(this);
+    pollTimer->setInterval(PollInterval);
+    connect(pollTimer, &QTimer::timeout, this, &CallLogFollower::readNewData);
+
+    flushTimer = new QTimer(this);
+    flushTimer->setSingleShot(true);
+    flushTimer->setInterval(FlushInterval);
+    connect(flushTimer, &QTimer::timeout, this, &CallLogFollower::flush);
+
+    // Дочитывание остатка после того, как цикл событий обработает остальное
+    continueTimer = new QTimer(this);
+    continueTimer->setSingleShot(true);
+    continueTimer->setInterval(0);
+    connect(continueTimer, &QTimer::timeout, this, &CallLogFollower::readNewData);
+}
+
+void CallLogFollower::start(const QString &path)
+{
+    stop();
+    filePath = path;
+    offset = 0;
+    line = 0;
+    pending.clear();
+    fingerprint.clear();
+    rejected = CallRecordRejects();
+    reportedRejects = 0;
+    watcher->addPath(path);
+    pollTimer->start();
+    readNewData();
+}
+
+void CallLogFollower::stop()
+{
+    if (!watcher->files().isEmpty())
+        watcher->removePaths(watcher->files());
+    pollTimer->stop();
+    flushTimer->stop();
+    continueTimer->stop();
+    flush();
+    filePath.clear();
+}
+
+void CallLogFollower::restart()
+{
+    offset = 0;
+    line = 0;
+    pending.clear();
+    fingerprint.clear();
+    emit fileRestarted();
+}
+
+void CallLogFollower::readNewData()
+{
+    if (filePath.isEmpty())
+        return;
+
+    // После переименования путь выпадает из наблюдения; возвращаем его, когда файл появится снова
+    if (!watcher->files().contains(filePath) && QFile::exists(filePath))
+        watcher->addPath(filePath);
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+    const qint64 size = file.size();
+
+    // Усечение видно по размеру, замена файла — по несовпадению начала
+    bool restarted = size < offset;
+    if (!restarted && !fingerprint.isEmpty())
+        restarted = file.read(fingerprint.size()) != fingerprint;
+    if (restarted)
+        restart();
+    if (fingerprint.size() < FingerprintSize && size > fingerprint.size()) {
+        file.seek(0);
+        fingerprint = file.read(FingerprintSize);
+    }
+
+    if (offset >= size || !file.seek(offset))
+        return;
+    const QByteArray chunk = file.read(qMin(ReadChunk, size - offset));
+    if (chunk.isEmpty())
+        return;
+    offset += chunk.size();
+    parseLines(chunk);
+    if (offset < size)
+        continueTimer->start();
+
+    if ((batch.size() > 0 || rejected.total() > reportedRejects) && !flushTimer->isActive())
+        flushTimer->start();
+}
+
+void CallLogFollower::appendLine(QByteArrayView text, SurnameDictionary::Utf8Cache &surnames)
+{
+    ++line;
+    const CallRecord::ParseStatus status = batch.appendLine(text, surnames);
+    if (status != CallRecord::Parsed && status != CallRecord::EmptyLine)
+        rejected.add(0, line, status, text);
+}
+
+void CallLogFollower::parseLines(const QByteArray &data)
+{
+    SurnameDictionary::Utf8Cache surnames;
+    qsizetype start = 0;
+    if (!pending.isEmpty()) {
+        const qsizetype end = data.indexOf('\n');
+        if (end < 0) {
+            pending += data;
+            return;
+        }
+        pending += QByteArrayView(data).first(end);
+        appendLine(pending, surnames);
+        pending.clear();
+        start = end + 1;
+    }
+
+    for (qsizetype end = data.indexOf('\n', start); end >= 0; end = data.indexOf('\n', start)) {
+        appendLine(QByteArrayView(data).sliced(start, end - start), surnames);
+        start = end + 1;
+    }
+    // Незавершённая строка дождётся следующей порции данных
+    pending = data.mid(start);
+}
+
+void CallLogFollower::flush()
+{
+    if (rejected.total() > reportedRejects) {
+        reportedRejects = rejected.total();
+        emit linesRejected(reportedRejects);
+    }
+    if (batch.size() == 0)
+        return;
+
+    const CallRecordColumns records = batch;
+    batch = CallRecordColumns();
+    emit recordsAppended(records);
+}
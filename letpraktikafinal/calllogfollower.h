@@ -0,0 +1,62 @@
+#ifndef CALLLOGFOLLOWER_H
+#define CALLLOGFOLLOWER_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QFileSystemWatcher>
+#include <QTimer>
+#include "callrecord.h"
+
+// Слежение за дописываемым файлом звонков: читаются только байты после
+// запомненного смещения, из них разбираются целые строки. За один заход
+// читается не больше ReadChunk байт, остаток — следующими заходами через
+// цикл событий, чтобы большой прирост файла не останавливал интерфейс.
+// Новые записи копятся и отдаются пачкой не чаще, чем раз в FlushInterval мс.
+class CallLogFollower : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CallLogFollower(QObject *parent = nullptr);
+
+    void start(const QString &path);
+    void stop();
+    bool isActive() const { return !filePath.isEmpty(); }
+    QString path() const { return filePath; }
+    qint64 position() const { return offset; }
+    // Отклонённые строки с начала слежения; номера строк считаются
+    // от начала файла и после его замены начинаются заново
+    const CallRecordRejects &rejects() const { return rejected; }
+
+signals:
+    void recordsAppended(const CallRecordColumns &records);
+    // С прошлой пачки добавились отклонённые строки, total — всего с начала
+    void linesRejected(qint64 total);
+    // Файл усечён или заменён новым — чтение началось заново
+    void fileRestarted();
+
+private slots:
+    void readNewData();
+    void flush();
+
+private:
+    QFileSystemWatcher *watcher;
+    QTimer *pollTimer;
+    QTimer *flushTimer;
+    QTimer *continueTimer;
+    QString filePath;
+    qint64 offset = 0;
+    qint64 line = 0;
+    QByteArray pending;
+    QByteArray fingerprint;
+    CallRecordColumns batch;
+    CallRecordRejects rejected;
+    qint64 reportedRejects = 0;
+
+    void appendLine(QByteArrayView text, SurnameDictionary::Utf8Cache &surnames);
+
+    void parseLines(const QByteArray &data);
+    void restart();
+};
+
+#endif // CALLLOGFOLLOWER_H
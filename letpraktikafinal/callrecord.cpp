@@ -0,0 +1,316 @@
+#include "callrecord.h"
+#include <QThread>
+#include <QtAlgorithms>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+
+constexpr quint64 Ones = 0x0101010101010101ull;
+constexpr quint64 HighBits = 0x8080808080808080ull;
+constexpr quint64 LowBits = 0x7F7F7F7F7F7F7F7Full;
+
+// Старший бит каждого нулевого байта (без ложных срабатываний от переносов)
+quint64 zeroBytes(quint64 word)
+{
+    return ~(((word & LowBits) + LowBits) | word) & HighBits;
+}
+
+// Старший бит каждого байта вне '0'..'9'
+quint64 nonDigitBytes(quint64 word)
+{
+    const quint64 shifted = word ^ (Ones * '0');
+    return (shifted | ((shifted & LowBits) + Ones * 0x76)) & HighBits;
+}
+
+// Старшие биты восьми байтов собираются в восьмибитную маску, байт i -> бит i
+quint32 byteBits(quint64 highBits)
+{
+    return quint32(((highBits >> 7) * 0x0102040810204080ull) >> 56);
+}
+
+// Поле из QString в ASCII; -1, если есть другие символы или поле длиннее буфера
+qsizetype toAscii(QStringView text, char *buffer, qsizetype capacity)
+{
+    if (text.size() > capacity)
+        return -1;
+    for (qsizetype i = 0; i < text.size(); ++i) {
+        const char16_t c = text.at(i).unicode();
+        if (c >= 0x80)
+            return -1;
+        buffer[i] = char(c);
+    }
+    return text.size();
+}
+
+template <typename T>
+void compact(QList<T> &column, const QList<int> &sortedRows)
+{
+    qsizetype write = sortedRows.constFirst();
+    qsizetype next = 0;
+    for (qsizetype read = write; read < column.size(); ++read) {
+        if (next < sortedRows.size() && sortedRows.at(next) == read) {
+            ++next;
+            continue;
+        }
+        column[write++] = std::move(column[read]);
+    }
+    column.resize(write);
+}
+
+}
+
+qint32 CallRecord::parseDuration(QByteArrayView text)
+{
+    text = text.trimmed();
+    if (text.isEmpty() || text.size() > 8)
+        return InvalidDuration;
+
+    // Цифры выравниваются по правому краю слова, слева дополняются '0'
+    char buffer[8];
+    std::memset(buffer, '0', sizeof(buffer));
+    std::memcpy(buffer + sizeof(buffer) - text.size(), text.data(), size_t(text.size()));
+    quint64 word = qFromLittleEndian<quint64>(buffer);
+    if (nonDigitBytes(word) != 0)
+        return InvalidDuration;
+
+    // Восемь цифр складываются попарно: 2 -> 4 -> 8 разрядов за три умножения
+    word -= Ones * '0';
+    word = (word * 10 + (word >> 8)) & 0x00FF00FF00FF00FFull;
+    word = (word * 100 + (word >> 16)) & 0x0000FFFF0000FFFFull;
+    word = (word * 10000 + (word >> 32)) & 0x00000000FFFFFFFFull;
+    return qint32(word);
+}
+
+quint32 CallRecord::parseIpv4(QByteArrayView text)
+{
+    text = text.trimmed();
+    if (text.size() < 7 || text.size() > 15)
+        return InvalidIp;
+
+    char buffer[16] = {};
+    std::memcpy(buffer, text.data(), size_t(text.size()));
+    const quint64 low = qFromLittleEndian<quint64>(buffer);
+    const quint64 high = qFromLittleEndian<quint64>(buffer + 8);
+    const quint32 used = (1u << text.size()) - 1;
+    const quint32 dots = (byteBits(zeroBytes(low ^ (Ones * '.'))) | byteBits(zeroBytes(high ^ (Ones * '.'))) << 8) & used;
+    const quint32 digits = ~(byteBits(nonDigitBytes(low)) | byteBits(nonDigitBytes(high)) << 8) & used;
+    if ((dots | digits) != used || qPopulationCount(dots) != 3)
+        return InvalidIp;
+
+    quint32 ip = 0;
+    quint32 rest = dots;
+    qsizetype start = 0;
+    for (int octet = 0; octet < 4; ++octet) {
+        const qsizetype end = octet < 3 ? qsizetype(qCountTrailingZeroBits(rest)) : text.size();
+        rest &= rest - 1;
+        const qsizetype length = end - start;
+        if (length < 1 || length > 3 || (length > 1 && text.at(start) == '0'))
+            return InvalidIp;
+        quint32 value = 0;
+        for (qsizetype i = start; i < end; ++i)
+            value = value * 10 + quint32(text.at(i) - '0');
+        if (value > 255)
+            return InvalidIp;
+        ip = (ip << 8) | value;
+        start = end + 1;
+    }
+    return ip;
+}
+
+qint32 CallRecord::parseDuration(QStringView text)
+{
+    char buffer[16];
+    const qsizetype size = toAscii(text.trimmed(), buffer, sizeof(buffer));
+    return size < 0 ? InvalidDuration : parseDuration(QByteArrayView(buffer, size));
+}
+
+quint32 CallRecord::parseIpv4(QStringView text)
+{
+    char buffer[16];
+    const qsizetype size = toAscii(text.trimmed(), buffer, sizeof(buffer));
+    return size < 0 ? InvalidIp : parseIpv4(QByteArrayView(buffer, size));
+}
+
+QString CallRecord::formatIpv4(quint32 ip)
+{
+    return QString("%1.%2.%3.%4")
+        .arg(ip >> 24)
+        .arg((ip >> 16) & 0xFF)
+        .arg((ip >> 8) & 0xFF)
+        .arg(ip & 0xFF);
+}
+
+void CallRecord::appendIpv4(QByteArray &out, quint32 ip)
+{
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        const quint32 octet = (ip >> shift) & 0xFF;
+        if (octet >= 100)
+            out.append(char('0' + octet / 100));
+        if (octet >= 10)
+            out.append(char('0' + octet / 10 % 10));
+        out.append(char('0' + octet % 10));
+        if (shift > 0)
+            out.append('.');
+    }
+}
+
+QString CallRecord::statusText(ParseStatus status)
+{
+    switch (status) {
+    case Parsed: return "принята";
+    case EmptyLine: return "пустая строка";
+    case WrongFieldCount: return "нужно три поля через запятую";
+    case BadDuration: return "неверное время разговора";
+    case BadIp: return "неверный IP адрес";
+    default: return QString();
+    }
+}
+
+QList<QPair<int, int>> CallRecord::partitions(int size, int minChunk)
+{
+    QList<QPair<int, int>> ranges;
+    if (size <= 0)
+        return ranges;
+
+    const int threads = qMax(1, QThread::idealThreadCount());
+    const int chunk = qMax(minChunk, (size + threads - 1) / threads);
+    for (int begin = 0; begin < size; begin += chunk)
+        ranges.append({begin, qMin(size, begin + chunk)});
+    return ranges;
+}
+
+qint64 CallRecordRejects::total() const
+{
+    qint64 sum = 0;
+    for (int status = CallRecord::WrongFieldCount; status < CallRecord::StatusCount; ++status)
+        sum += counts[status];
+    return sum;
+}
+
+void CallRecordRejects::add(int file, qint64 line, CallRecord::ParseStatus status, QByteArrayView text)
+{
+    ++counts[status];
+    if (samples.size() < MaxSamples)
+        samples.append({file, line, status, text.first(qMin(text.size(), MaxSampleLength)).toByteArray()});
+}
+
+void CallRecordRejects::merge(const CallRecordRejects &other, qint64 lineOffset)
+{
+    for (int status = 0; status < CallRecord::StatusCount; ++status)
+        counts[status] += other.counts[status];
+    for (const Sample &sample : other.samples) {
+        if (samples.size() >= MaxSamples)
+            break;
+        samples.append(sample);
+        samples.last().line += lineOffset;
+    }
+}
+
+QString CallRecordRejects::summary(const QStringList &filenames) const
+{
+    QStringList lines;
+    for (int status = CallRecord::WrongFieldCount; status < CallRecord::StatusCount; ++status) {
+        if (counts[status] > 0)
+            lines << QString("%1: %2").arg(CallRecord::statusText(CallRecord::ParseStatus(status))).arg(counts[status]);
+    }
+    for (const Sample &sample : samples) {
+        const QString file = sample.file < filenames.size() ? filenames.at(sample.file) : QString();
+        lines << QString("%1:%2: %3: %4")
+                     .arg(file)
+                     .arg(sample.line)
+                     .arg(CallRecord::statusText(sample.status), QString::fromUtf8(sample.text));
+    }
+    return lines.join('\n');
+}
+
+void CallRecordColumns::reserve(int count)
+{
+    surnameIds.reserve(count);
+    durations.reserve(count);
+    ips.reserve(count);
+}
+
+CallRecord::ParseStatus CallRecordColumns::append(const QString &lastName, const QString &duration, const QString &ip)
+{
+    const qint32 minutes = CallRecord::parseDuration(duration);
+    if (minutes == CallRecord::InvalidDuration)
+        return CallRecord::BadDuration;
+    const quint32 address = CallRecord::parseIpv4(ip);
+    if (address == CallRecord::InvalidIp)
+        return CallRecord::BadIp;
+
+    surnameIds.append(SurnameDictionary::shared().intern(lastName));
+    durations.append(minutes);
+    ips.append(address);
+    return CallRecord::Parsed;
+}
+
+void CallRecordColumns::append(const CallRecordColumns &other)
+{
+    surnameIds.append(other.surnameIds);
+    durations.append(other.durations);
+    ips.append(other.ips);
+}
+
+void CallRecordColumns::appendRow(const CallRecordColumns &other, int row)
+{
+    surnameIds.append(other.surnameIds.at(row));
+    durations.append(other.durations.at(row));
+    ips.append(other.ips.at(row));
+}
+
+CallRecord::ParseStatus CallRecordColumns::appendLine(QByteArrayView line, SurnameDictionary::Utf8Cache &surnames)
+{
+    if (line.endsWith('\r'))
+        line.chop(1);
+    if (line.trimmed().isEmpty())
+        return CallRecord::EmptyLine;
+
+    const qsizetype first = line.indexOf(',');
+    const qsizetype second = first < 0 ? -1 : line.indexOf(',', first + 1);
+    if (second < 0 || line.indexOf(',', second + 1) >= 0)
+        return CallRecord::WrongFieldCount;
+
+    // Числа проверяются до обращения к словарю: отклонённая строка не добавит фамилию
+    const qint32 minutes = CallRecord::parseDuration(line.sliced(first + 1, second - first - 1));
+    if (minutes == CallRecord::InvalidDuration)
+        return CallRecord::BadDuration;
+    const quint32 address = CallRecord::parseIpv4(line.sliced(second + 1));
+    if (address == CallRecord::InvalidIp)
+        return CallRecord::BadIp;
+
+    surnameIds.append(surnames.intern(line.first(first)));
+    durations.append(minutes);
+    ips.append(address);
+    return CallRecord::Parsed;
+}
+
+qint64 CallRecordColumns::appendLines(QByteArrayView data, CallRecordRejects &rejects, int file)
+{
+    SurnameDictionary::Utf8Cache surnames;
+    qint64 line = 0;
+    qsizetype start = 0;
+    while (start < data.size()) {
+        qsizetype end = data.indexOf('\n', start);
+        if (end < 0)
+            end = data.size();
+        ++line;
+        const QByteArrayView text = data.sliced(start, end - start);
+        const CallRecord::ParseStatus status = appendLine(text, surnames);
+        if (status != CallRecord::Parsed && status != CallRecord::EmptyLine)
+            rejects.add(file, line, status, text);
+        start = end + 1;
+    }
+    return line;
+}
+
+void CallRecordColumns::removeRows(const QList<int> &sortedRows)
+{
+    if (sortedRows.isEmpty())
+        return;
+
+    compact(surnameIds, sortedRows);
+    compact(durations, sortedRows);
+    compact(ips, sortedRows);
+}
@@ -0,0 +1,122 @@
+#ifndef CALLRECORD_H
+#define CALLRECORD_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QList>
+#include <QPair>
+#include <QString>
+#include <QStringList>
+#include <QStringView>
+#include <QFuture>
+#include <QtConcurrent>
+#include <array>
+#include "surnamedictionary.h"
+
+namespace CallRecord {
+
+constexpr qint32 InvalidDuration = -1;
+// 255.255.255.255 — широковещательный адрес, у абонента его быть не может
+constexpr quint32 InvalidIp = 0xFFFFFFFFu;
+
+// Разбор без ветвлений по символам: поле загружается в 64-битные слова,
+// проверка цифр и поиск точек идут сразу по восьми байтам (SWAR).
+// Время — целое число минут, до 8 цифр; IPv4 — четыре числа 0..255
+// через точку, без ведущих нулей. Пробелы по краям допускаются.
+qint32 parseDuration(QByteArrayView text);
+quint32 parseIpv4(QByteArrayView text);
+qint32 parseDuration(QStringView text);
+quint32 parseIpv4(QStringView text);
+QString formatIpv4(quint32 ip);
+void appendIpv4(QByteArray &out, quint32 ip);
+
+enum ParseStatus {
+    Parsed,
+    EmptyLine,
+    WrongFieldCount,
+    BadDuration,
+    BadIp,
+    StatusCount
+};
+
+QString statusText(ParseStatus status);
+
+// Разбиение [0, size) на диапазоны для параллельной обработки
+QList<QPair<int, int>> partitions(int size, int minChunk = 65536);
+
+// Вызывает function(partition, begin, end) для каждого диапазона в пуле потоков и ждёт завершения
+template <typename Function>
+void forEachPartition(const QList<QPair<int, int>> &ranges, Function function)
+{
+    if (ranges.size() == 1) {
+        function(0, ranges.at(0).first, ranges.at(0).second);
+        return;
+    }
+
+    QList<QFuture<void>> futures;
+    futures.reserve(ranges.size());
+    for (int i = 0; i < ranges.size(); ++i) {
+        futures.append(QtConcurrent::run([&function, &ranges, i]() {
+            function(i, ranges.at(i).first, ranges.at(i).second);
+        }));
+    }
+    for (QFuture<void> &future : futures)
+        future.waitForFinished();
+}
+
+}
+
+// Отклонённые при разборе строки: счётчики по причинам и первые примеры
+struct CallRecordRejects
+{
+    static constexpr int MaxSamples = 20;
+    static constexpr qsizetype MaxSampleLength = 80;
+
+    struct Sample
+    {
+        int file;
+        qint64 line;
+        CallRecord::ParseStatus status;
+        QByteArray text;
+    };
+
+    std::array<qint64, CallRecord::StatusCount> counts {};
+    QList<Sample> samples;
+
+    qint64 total() const;
+    void add(int file, qint64 line, CallRecord::ParseStatus status, QByteArrayView text);
+    // Номера строк other сдвигаются на lineOffset (кусок файла начинается не с первой строки)
+    void merge(const CallRecordRejects &other, qint64 lineOffset = 0);
+    QString summary(const QStringList &filenames) const;
+};
+
+// Записи хранятся по столбцам: копия структуры дешёвая (implicit sharing),
+// поэтому её можно отдавать рабочим потокам как снимок данных.
+// Фамилии — номера в SurnameDictionary::shared(); время и IP хранятся
+// только числами, в таблицу попадают лишь проверенные значения.
+struct CallRecordColumns
+{
+    QList<quint32> surnameIds;
+    QList<qint32> durations;
+    QList<quint32> ips;
+
+    int size() const { return int(surnameIds.size()); }
+    QString lastName(int row) const { return SurnameDictionary::shared().text(surnameIds.at(row)); }
+    QString durationText(int row) const { return QString::number(durations.at(row)); }
+    QString ipText(int row) const { return CallRecord::formatIpv4(ips.at(row)); }
+    void reserve(int count);
+    // Поля проверяются; при ошибке запись не добавляется
+    CallRecord::ParseStatus append(const QString &lastName, const QString &duration, const QString &ip);
+    void append(const CallRecordColumns &other);
+    void appendRow(const CallRecordColumns &other, int row);
+    // Строка файла "Фамилия,Время,IP" в UTF-8; фамилия ищется через
+    // surnames, общий на весь разбираемый кусок
+    CallRecord::ParseStatus appendLine(QByteArrayView line, SurnameDictionary::Utf8Cache &surnames);
+    // Текст из нескольких строк; отклонённые попадают в rejects с номером
+    // строки (с единицы) и номером файла. Возвращает число строк.
+    qint64 appendLines(QByteArrayView data, CallRecordRejects &rejects, int file = 0);
+    // Удаление отсортированного набора строк за один проход
+    void removeRows(const QList<int> &sortedRows);
+};
+
+#endif // CALLRECORD_H
@@ -0,0 +1,258 @@
+#include "callrecordimporter.h"
+#include "perfmonitor.h"
+#include <QFile>
+#include <QHash>
+#include <QThread>
+#include <algorithm>
+#include <memory>
+#include <queue>
+#include <vector>
+
+namespace {
+
+constexpr qsizetype ChunkSize = 8 * 1024 * 1024;
+
+struct Chunk
+{
+    int file;
+    QByteArrayView data;
+};
+
+struct ParsedChunk
+{
+    CallRecordColumns records;
+    CallRecordRejects rejects;
+    qint64 lines = 0;
+    bool sorted = true;
+};
+
+// ranks — SurnameDictionary::ranks(), снятый после разбора всех кусков
+int compareRows(const QList<quint32> &ranks, const CallRecordColumns &a, int i, const CallRecordColumns &b, int j)
+{
+    const quint32 first = ranks.at(a.surnameIds.at(i));
+    const quint32 second = ranks.at(b.surnameIds.at(j));
+    int result = first < second ? -1 : first > second;
+    if (result == 0)
+        result = a.durations.at(i) < b.durations.at(j) ? -1 : a.durations.at(i) > b.durations.at(j);
+    if (result == 0)
+        result = a.ips.at(i) < b.ips.at(j) ? -1 : a.ips.at(i) > b.ips.at(j);
+    return result;
+}
+
+ParsedChunk parseChunk(QByteArrayView data, int file)
+{
+    ParsedChunk parsed;
+    parsed.lines = parsed.records.appendLines(data, parsed.rejects, file);
+    return parsed;
+}
+
+bool isSorted(const QList<quint32> &ranks, const CallRecordColumns &records)
+{
+    for (int row = 1; row < records.size(); ++row) {
+        if (compareRows(ranks, records, row - 1, records, row) > 0)
+            return false;
+    }
+    return true;
+}
+
+// Запись считается повтором, если такая же есть в одном из предыдущих файлов;
+// совпадения внутри одного файла — это разные звонки, они остаются.
+// Строки за один проход раскладываются по хешу на сегменты, каждый сегмент
+// проверяется в своём потоке.
+QList<int> findDuplicates(const CallRecordColumns &records, const QList<int> &fileStarts)
+{
+    const int size = records.size();
+    const int shards = qMax(1, QThread::idealThreadCount());
+    const QList<QPair<int, int>> ranges = CallRecord::partitions(size);
+    QList<size_t> hashes(size);
+    // Строки каждого диапазона по сегментам, в порядке возрастания
+    QList<QList<QList<int>>> bucketed(ranges.size(), QList<QList<int>>(shards));
+    CallRecord::forEachPartition(ranges, [&](int partition, int begin, int end) {
+        QList<QList<int>> &buckets = bucketed[partition];
+        for (int row = begin; row < end; ++row) {
+            const size_t hash = qHashMulti(0, records.surnameIds.at(row), records.durations.at(row), records.ips.at(row));
+            hashes[row] = hash;
+            buckets[int(hash % size_t(shards))].append(row);
+        }
+    });
+
+    const auto fileOf = [&fileStarts](int row) {
+        return int(std::upper_bound(fileStarts.cbegin(), fileStarts.cend(), row) - fileStarts.cbegin());
+    };
+    // Одинаковые фамилии — один номер в словаре, строки сравниваются числами
+    const auto sameRow = [&records](int a, int b) {
+        return records.surnameIds.at(a) == records.surnameIds.at(b)
+            && records.durations.at(a) == records.durations.at(b)
+            && records.ips.at(a) == records.ips.at(b);
+    };
+
+    QList<QPair<int, int>> shardRanges;
+    for (int shard = 0; shard < shards; ++shard)
+        shardRanges.append({shard, shard + 1});
+
+    QList<QList<int>> found(shards);
+    CallRecord::forEachPartition(shardRanges, [&](int shard, int, int) {
+        // Первая строка каждой различной записи; при совпадении хешей
+        // у разных записей под одним ключом лежат все они
+        QMultiHash<size_t, int> firstRows;
+        for (const QList<QList<int>> &buckets : std::as_const(bucketed)) {
+            for (int row : buckets.at(shard)) {
+                const size_t hash = hashes.at(row);
+                int first = -1;
+                const auto [begin, end] = std::as_const(firstRows).equal_range(hash);
+                for (auto it = begin; it != end && first < 0; ++it) {
+                    if (sameRow(it.value(), row))
+                        first = it.value();
+                }
+                if (first < 0)
+                    firstRows.insert(hash, row);
+                else if (fileOf(first) < fileOf(row))
+                    found[shard].append(row);
+            }
+        }
+    });
+
+    QList<int> duplicates;
+    for (const QList<int> &rows : found)
+        duplicates.append(rows);
+    std::sort(duplicates.begin(), duplicates.end());
+    return duplicates;
+}
+
+}
+
+CallRecordImporter::Result CallRecordImporter::importFiles(const QStringList &filenames)
+{
+    Result result;
+
+    // Отображённые файлы должны жить, пока разбираются их куски
+    std::vector<std::unique_ptr<QFile>> files;
+    QList<QByteArray> buffers;
+    QList<Chunk> chunks;
+    for (int index = 0; index < filenames.size(); ++index) {
+        auto file = std::make_unique<QFile>(filenames.at(index));
+        if (!file->open(QIODevice::ReadOnly)) {
+            result.errors.append(QString("%1: %2").arg(filenames.at(index), file->errorString()));
+            files.push_back(std::move(file));
+            continue;
+        }
+
+        const qsizetype size = file->size();
+        QByteArrayView content;
+        if (uchar *mapped = size > 0 ? file->map(0, size) : nullptr) {
+            content = QByteArrayView(mapped, size);
+        } else {
+            buffers.append(file->readAll());
+            content = buffers.constLast();
+        }
+
+        for (qsizetype start = 0; start < content.size();) {
+            qsizetype end = qMin(content.size(), start + ChunkSize);
+            if (end < content.size()) {
+                const qsizetype newline = content.indexOf('\n', end);
+                end = newline < 0 ? content.size() : newline + 1;
+            }
+            chunks.append({index, content.sliced(start, end - start)});
+            start = end;
+        }
+        files.push_back(std::move(file));
+    }
+
+    QList<QPair<int, int>> tasks;
+    for (int i = 0; i < chunks.size(); ++i)
+        tasks.append({i, i + 1});
+    QList<ParsedChunk> parsed(chunks.size());
+    CallRecord::forEachPartition(tasks, [&](int task, int, int) {
+        PerfMonitor::Scope scope("parse");
+        parsed[task] = parseChunk(chunks.at(task).data, chunks.at(task).file);
+        scope.setRows(parsed.at(task).records.size());
+    });
+
+    // Все фамилии уже в словаре: дальше порядок строк сравнивается по рангам
+    const QList<quint32> ranks = SurnameDictionary::shared().ranks();
+    CallRecord::forEachPartition(tasks, [&](int task, int, int) {
+        parsed[task].sorted = isSorted(ranks, parsed.at(task).records);
+    });
+
+    // Сборка по файлам с проверкой порядка на стыках кусков
+    QList<CallRecordColumns> perFile(filenames.size());
+    QList<bool> sorted(filenames.size(), true);
+    QList<qint64> linesRead(filenames.size(), 0);
+    for (int i = 0; i < chunks.size(); ++i) {
+        const int file = chunks.at(i).file;
+        ParsedChunk &chunk = parsed[i];
+        result.rejects.merge(chunk.rejects, linesRead.at(file));
+        linesRead[file] += chunk.lines;
+        CallRecordColumns &target = perFile[file];
+        sorted[file] = sorted.at(file) && chunk.sorted;
+        if (target.size() == 0) {
+            target = std::move(chunk.records);
+            continue;
+        }
+        if (chunk.records.size() > 0 && compareRows(ranks, target, target.size() - 1, chunk.records, 0) > 0)
+            sorted[file] = false;
+        target.append(chunk.records);
+    }
+    parsed.clear();
+
+    int total = 0;
+    for (const CallRecordColumns &records : perFile)
+        total += records.size();
+
+    result.merged = filenames.size() > 1 && !sorted.contains(false);
+    if (result.merged) {
+        struct Cursor
+        {
+            int file;
+            int row;
+        };
+        const auto greater = [&perFile, &ranks](const Cursor &a, const Cursor &b) {
+            const int order = compareRows(ranks, perFile.at(a.file), a.row, perFile.at(b.file), b.row);
+            return order != 0 ? order > 0 : a.file > b.file;
+        };
+        std::priority_queue<Cursor, std::vector<Cursor>, decltype(greater)> heap(greater);
+        for (int file = 0; file < perFile.size(); ++file) {
+            if (perFile.at(file).size() > 0)
+                heap.push({file, 0});
+        }
+
+        // Равные записи идут подряд, от файла с меньшим номером к большему
+        PerfMonitor::Scope scope("merge", total);
+        CallRecordColumns &records = result.records;
+        records.reserve(total);
+        int runFile = -1;
+        while (!heap.empty()) {
+            Cursor cursor = heap.top();
+            heap.pop();
+            const CallRecordColumns &source = perFile.at(cursor.file);
+            const bool equal = records.size() > 0 && compareRows(ranks, records, records.size() - 1, source, cursor.row) == 0;
+            if (!equal)
+                runFile = cursor.file;
+            if (equal && cursor.file != runFile)
+                ++result.duplicates;
+            else
+                records.appendRow(source, cursor.row);
+            if (++cursor.row < source.size())
+                heap.push(cursor);
+        }
+        return result;
+    }
+
+    QList<int> fileStarts;
+    for (int file = 0; file < perFile.size(); ++file) {
+        fileStarts.append(result.records.size());
+        if (result.records.size() == 0)
+            result.records = std::move(perFile[file]);
+        else
+            result.records.append(perFile.at(file));
+    }
+    if (filenames.size() > 1) {
+        // fileStarts[0] == 0 лишний для поиска номера файла
+        fileStarts.removeFirst();
+        PerfMonitor::Scope scope("dedup", result.records.size());
+        const QList<int> duplicates = findDuplicates(result.records, fileStarts);
+        result.records.removeRows(duplicates);
+        result.duplicates = int(duplicates.size());
+    }
+    return result;
+}
@@ -0,0 +1,28 @@
+#ifndef CALLRECORDIMPORTER_H
+#define CALLRECORDIMPORTER_H
+
+#include <QStringList>
+#include "callrecord.h"
+
+class CallRecordImporter
+{
+public:
+    struct Result
+    {
+        CallRecordColumns records;
+        int duplicates = 0;
+        bool merged = false;
+        QStringList errors;
+        // Строки с неверным числом полей, временем или IP
+        CallRecordRejects rejects;
+    };
+
+    // Файлы отображаются в память и режутся на куски по границам строк;
+    // куски всех файлов разбираются параллельно. Если каждый файл уже
+    // упорядочен по (фамилия, время, IP), файлы сливаются k-путевым слиянием,
+    // иначе склеиваются по порядку. Точные повторы удаляются.
+    // Время и IP проверяются при разборе, неверные строки идут в отчёт.
+    static Result importFiles(const QStringList &filenames);
+};
+
+#endif // CALLRECORDIMPORTER_H
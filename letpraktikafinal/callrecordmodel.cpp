@@ -0,0 +1,368 @@
+#include "callrecordmodel.h"
+#include <algorithm>
+#include <iterator>
+#include <numeric>
+
+CallRecordModel::CallRecordModel(QObject *parent)
+    : QAbstractTableModel(parent)
+{
+}
+
+int CallRecordModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return 0;
+    return isMapped() ? int(visibleRows.size()) : storage.size();
+}
+
+int CallRecordModel::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant CallRecordModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || (role != Qt::DisplayRole && role != Qt::EditRole))
+        return QVariant();
+
+    const int row = sourceRow(index.row());
+    switch (index.column()) {
+    case LastNameColumn: return storage.lastName(row);
+    case DurationColumn: return storage.durationText(row);
+    case IpColumn: return storage.ipText(row);
+    default: return QVariant();
+    }
+}
+
+QVariant CallRecordModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal)
+        return QAbstractTableModel::headerData(section, orientation, role);
+
+    switch (section) {
+    case LastNameColumn: return "Фамилия";
+    case DurationColumn: return "Время разговора";
+    case IpColumn: return "IP адрес";
+    default: return QVariant();
+    }
+}
+
+Qt::ItemFlags CallRecordModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid())
+        return Qt::NoItemFlags;
+    return QAbstractTableModel::flags(index) | Qt::ItemIsEditable;
+}
+
+bool CallRecordModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+    if (!index.isValid() || role != Qt::EditRole)
+        return false;
+
+    const int row = sourceRow(index.row());
+    const QString text = value.toString();
+    switch (index.column()) {
+    case LastNameColumn:
+        lastNameIndex.remove(storage.surnameIds.at(row), row);
+        storage.surnameIds[row] = SurnameDictionary::shared().intern(text);
+        lastNameIndex.insert(storage.surnameIds.at(row), row);
+        break;
+    case DurationColumn: {
+        // Неверное значение не принимается, в ячейке остаётся прежнее
+        const qint32 minutes = CallRecord::parseDuration(text);
+        if (minutes == CallRecord::InvalidDuration)
+            return false;
+        durationStats.remove(storage.durations.at(row));
+        storage.durations[row] = minutes;
+        durationStats.add(minutes);
+        break;
+    }
+    case IpColumn: {
+        const quint32 address = CallRecord::parseIpv4(text);
+        if (address == CallRecord::InvalidIp)
+            return false;
+        ipPrefixIndex.remove(storage.ips.at(row), row);
+        storage.ips[row] = address;
+        ipPrefixIndex.insert(address, row);
+        break;
+    }
+    default:
+        return false;
+    }
+    emit dataChanged(index, index, {Qt::DisplayRole, Qt::EditRole});
+    if (index.column() == DurationColumn)
+        emit statisticsChanged();
+    return true;
+}
+
+bool CallRecordModel::removeRows(int row, int count, const QModelIndex &parent)
+{
+    if (parent.isValid() || row < 0 || count <= 0 || row + count > rowCount())
+        return false;
+
+    QList<int> sourceRows;
+    sourceRows.reserve(count);
+    for (int i = row; i < row + count; ++i)
+        sourceRows.append(sourceRow(i));
+    std::sort(sourceRows.begin(), sourceRows.end());
+
+    beginRemoveRows(QModelIndex(), row, row + count - 1);
+    if (isMapped())
+        visibleRows.remove(row, count);
+    removeSourceRows(sourceRows);
+    endRemoveRows();
+    emit statisticsChanged();
+    return true;
+}
+
+CallRecord::ParseStatus CallRecordModel::appendRecord(const QString &lastName, const QString &duration, const QString &ip)
+{
+    CallRecordColumns record;
+    const CallRecord::ParseStatus status = record.append(lastName, duration, ip);
+    if (status == CallRecord::Parsed)
+        appendRecords(record);
+    return status;
+}
+
+void CallRecordModel::appendRecords(const CallRecordColumns &records)
+{
+    if (records.size() == 0)
+        return;
+    PerfMonitor::Scope scope("append", records.size());
+
+    const QList<int> visible = visibleAmong(records, storage.size());
+    const int inserted = isMapped() ? int(visible.size()) : records.size();
+    if (inserted > 0)
+        beginInsertRows(QModelIndex(), rowCount(), rowCount() + inserted - 1);
+
+    appendSourceRows(records);
+
+    if (inserted > 0) {
+        visibleRows.append(visible);
+        endInsertRows();
+    }
+    emit statisticsChanged();
+}
+
+void CallRecordModel::setColumns(const CallRecordColumns &columns)
+{
+    PerfMonitor::Scope scope("insert", columns.size());
+    beginResetModel();
+    storage = columns;
+    ipPrefixIndex.build(storage.ips);
+    lastNameIndex.build(storage.surnameIds);
+    durationStats = DurationStats::fromColumns(storage);
+    rebuildVisibleRows();
+    endResetModel();
+    emit statisticsChanged();
+}
+
+void CallRecordModel::applyChanges(const QList<int> &removedRows, const CallRecordColumns &inserted)
+{
+    QList<int> sourceRows;
+    sourceRows.reserve(removedRows.size());
+    for (int row : removedRows) {
+        if (row >= 0 && row < rowCount())
+            sourceRows.append(sourceRow(row));
+    }
+    std::sort(sourceRows.begin(), sourceRows.end());
+    sourceRows.erase(std::unique(sourceRows.begin(), sourceRows.end()), sourceRows.end());
+    if (sourceRows.isEmpty() && inserted.size() == 0)
+        return;
+    PerfMonitor::Scope scope("batch", sourceRows.size() + inserted.size());
+
+    beginResetModel();
+    if (!sourceRows.isEmpty()) {
+        if (isMapped()) {
+            visibleRows.removeIf([&sourceRows](int row) {
+                return std::binary_search(sourceRows.cbegin(), sourceRows.cend(), row);
+            });
+        }
+        removeSourceRows(sourceRows);
+    }
+    if (inserted.size() > 0) {
+        // Как и при обычном добавлении, новые записи встают в конец до следующей сортировки
+        const QList<int> visible = visibleAmong(inserted, storage.size());
+        appendSourceRows(inserted);
+        visibleRows.append(visible);
+    }
+    endResetModel();
+    emit statisticsChanged();
+}
+
+void CallRecordModel::setIpFilter(quint32 first, quint32 last)
+{
+    beginResetModel();
+    ipFiltered = true;
+    filterFirst = first;
+    filterLast = last;
+    rebuildVisibleRows();
+    endResetModel();
+}
+
+void CallRecordModel::clearIpFilter()
+{
+    if (!ipFiltered)
+        return;
+
+    beginResetModel();
+    ipFiltered = false;
+    rebuildVisibleRows();
+    endResetModel();
+}
+
+void CallRecordModel::setSurnameFilter(const QString &query, SurnameIndex::MatchMode mode)
+{
+    beginResetModel();
+    surnameFiltered = true;
+    surnameQuery = SurnameIndex::fold(query.trimmed());
+    surnameMode = mode;
+    rebuildVisibleRows();
+    endResetModel();
+}
+
+void CallRecordModel::clearSurnameFilter()
+{
+    if (!surnameFiltered)
+        return;
+
+    beginResetModel();
+    surnameFiltered = false;
+    surnameQuery.clear();
+    rebuildVisibleRows();
+    endResetModel();
+}
+
+void CallRecordModel::sort(int column, Qt::SortOrder order)
+{
+    if (column < 0 || column >= ColumnCount)
+        return;
+
+    // Новый ключ становится главным, прежние остаются дополнительными
+    QList<CallSorter::SortKey> keys = sortKeys;
+    keys.removeIf([column](const CallSorter::SortKey &key) { return key.column == column; });
+    keys.prepend({column, order});
+    sortBy(keys);
+}
+
+void CallRecordModel::sortBy(const QList<CallSorter::SortKey> &keys)
+{
+    PerfMonitor::Scope scope("sort", storage.size());
+    emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+
+    const QModelIndexList persistent = persistentIndexList();
+    QList<int> persistentRows;
+    persistentRows.reserve(persistent.size());
+    for (const QModelIndex &index : persistent)
+        persistentRows.append(sourceRow(index.row()));
+
+    sortKeys = keys;
+    rebuildVisibleRows();
+
+    if (!persistent.isEmpty()) {
+        QList<int> positions(storage.size(), -1);
+        for (int row = 0; row < rowCount(); ++row)
+            positions[sourceRow(row)] = row;
+
+        QModelIndexList updated;
+        updated.reserve(persistent.size());
+        for (int i = 0; i < persistent.size(); ++i) {
+            const int row = positions.at(persistentRows.at(i));
+            updated.append(row < 0 ? QModelIndex() : index(row, persistent.at(i).column()));
+        }
+        changePersistentIndexList(persistent, updated);
+    }
+
+    emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+}
+
+void CallRecordModel::rebuildVisibleRows()
+{
+    if (ipFiltered && surnameFiltered) {
+        const QList<int> inRange = ipPrefixIndex.rowsInRange(filterFirst, filterLast);
+        const QList<int> named = lastNameIndex.rowsMatching(surnameQuery, surnameMode);
+        visibleRows.clear();
+        std::set_intersection(inRange.cbegin(), inRange.cend(), named.cbegin(), named.cend(),
+                              std::back_inserter(visibleRows));
+    } else if (ipFiltered) {
+        visibleRows = ipPrefixIndex.rowsInRange(filterFirst, filterLast);
+    } else if (surnameFiltered) {
+        visibleRows = lastNameIndex.rowsMatching(surnameQuery, surnameMode);
+    } else if (!sortKeys.isEmpty()) {
+        visibleRows.resize(storage.size());
+        std::iota(visibleRows.begin(), visibleRows.end(), 0);
+    } else {
+        visibleRows.clear();
+    }
+
+    if (!sortKeys.isEmpty())
+        visibleRows = CallSorter::sortedRows(storage, visibleRows, sortKeys);
+}
+
+bool CallRecordModel::matchesFilter(quint32 surnameId, quint32 ip) const
+{
+    if (ipFiltered && (ip == CallRecord::InvalidIp || ip < filterFirst || ip > filterLast))
+        return false;
+    if (surnameFiltered && !lastNameIndex.matchesId(surnameId, surnameQuery, surnameMode))
+        return false;
+    return true;
+}
+
+QList<int> CallRecordModel::visibleAmong(const CallRecordColumns &records, int first) const
+{
+    QList<int> visible;
+    if (!isMapped())
+        return visible;
+    for (int i = 0; i < records.size(); ++i) {
+        if (!isFiltered() || matchesFilter(records.surnameIds.at(i), records.ips.at(i)))
+            visible.append(first + i);
+    }
+    return visible;
+}
+
+void CallRecordModel::appendSourceRows(const CallRecordColumns &records)
+{
+    const int first = storage.size();
+    storage.append(records);
+    for (int i = 0; i < records.size(); ++i) {
+        if (records.ips.at(i) != CallRecord::InvalidIp)
+            ipPrefixIndex.insert(records.ips.at(i), first + i);
+        lastNameIndex.insert(records.surnameIds.at(i), first + i);
+    }
+    durationStats.merge(DurationStats::fromColumns(records));
+}
+
+void CallRecordModel::removeSourceRows(const QList<int> &sortedRows)
+{
+    // Если удаляется заметная часть записей, индексы быстрее построить заново
+    const bool rebuild = sortedRows.size() > storage.size() / 8;
+    if (!rebuild) {
+        for (int row : sortedRows) {
+            if (storage.ips.at(row) != CallRecord::InvalidIp)
+                ipPrefixIndex.remove(storage.ips.at(row), row);
+            lastNameIndex.remove(storage.surnameIds.at(row), row);
+            durationStats.remove(storage.durations.at(row));
+        }
+        ipPrefixIndex.shiftRows(sortedRows);
+        lastNameIndex.shiftRows(sortedRows);
+    }
+    storage.removeRows(sortedRows);
+    if (rebuild) {
+        ipPrefixIndex.build(storage.ips);
+        lastNameIndex.build(storage.surnameIds);
+        durationStats = DurationStats::fromColumns(storage);
+    }
+
+    for (int &row : visibleRows)
+        row -= int(std::lower_bound(sortedRows.cbegin(), sortedRows.cend(), row) - sortedRows.cbegin());
+}
+
+qsizetype CallRecordModel::memoryUsage() const
+{
+    return storage.surnameIds.capacity() * qsizetype(sizeof(quint32))
+        + storage.durations.capacity() * qsizetype(sizeof(qint32))
+        + storage.ips.capacity() * qsizetype(sizeof(quint32))
+        + visibleRows.capacity() * qsizetype(sizeof(int))
+        + ipPrefixIndex.memoryUsage()
+        + lastNameIndex.memoryUsage();
+}
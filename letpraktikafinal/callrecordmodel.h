@@ -0,0 +1,90 @@
+#ifndef CALLRECORDMODEL_H
+#define CALLRECORDMODEL_H
+
+#include <QAbstractTableModel>
+#include "callrecord.h"
+#include "ipprefixindex.h"
+#include "surnameindex.h"
+#include "callsorter.h"
+#include "durationstats.h"
+#include "perfmonitor.h"
+
+class CallRecordModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        LastNameColumn,
+        DurationColumn,
+        IpColumn,
+        ColumnCount
+    };
+
+    explicit CallRecordModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+    bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
+    bool removeRows(int row, int count, const QModelIndex &parent = QModelIndex()) override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    // Время и IP проверяются; неверная запись не добавляется
+    CallRecord::ParseStatus appendRecord(const QString &lastName, const QString &duration, const QString &ip);
+    // Пачка записей добавляется одним уведомлением для представлений
+    void appendRecords(const CallRecordColumns &records);
+    void setColumns(const CallRecordColumns &columns);
+    // Пакет изменений: удаляются строки removedRows (номера в представлении),
+    // затем в конец добавляются inserted. Хранилище уплотняется за один проход,
+    // представления получают одно уведомление о сбросе.
+    void applyChanges(const QList<int> &removedRows, const CallRecordColumns &inserted = CallRecordColumns());
+    const CallRecordColumns &columns() const { return storage; }
+    int recordCount() const { return storage.size(); }
+
+    // Фильтры по диапазону IP и по фамилии: видимые строки берутся из индексов
+    void setIpFilter(quint32 first, quint32 last);
+    void clearIpFilter();
+    void setSurnameFilter(const QString &query, SurnameIndex::MatchMode mode);
+    void clearSurnameFilter();
+    bool isFiltered() const { return ipFiltered || surnameFiltered; }
+    int sourceRow(int row) const { return isMapped() ? visibleRows.at(row) : row; }
+    const IpPrefixIndex &ipIndex() const { return ipPrefixIndex; }
+    const SurnameIndex &surnameIndex() const { return lastNameIndex; }
+    // Статистика по всем записям, без учёта фильтров
+    const DurationStats &statistics() const { return durationStats; }
+    // Оценка памяти столбцов, индексов и списка видимых строк
+    qsizetype memoryUsage() const;
+
+    // Многоключевая сортировка: переставляется только список видимых строк
+    void sortBy(const QList<CallSorter::SortKey> &keys);
+    const QList<CallSorter::SortKey> &sortOrder() const { return sortKeys; }
+
+signals:
+    void statisticsChanged();
+
+private:
+    CallRecordColumns storage;
+    IpPrefixIndex ipPrefixIndex;
+    SurnameIndex lastNameIndex;
+    DurationStats durationStats;
+    QList<int> visibleRows;
+    QList<CallSorter::SortKey> sortKeys;
+    bool ipFiltered = false;
+    quint32 filterFirst = 0;
+    quint32 filterLast = 0;
+    bool surnameFiltered = false;
+    QString surnameQuery;
+    SurnameIndex::MatchMode surnameMode = SurnameIndex::SubstringMatch;
+
+    bool isMapped() const { return isFiltered() || !sortKeys.isEmpty(); }
+    bool matchesFilter(quint32 surnameId, quint32 ip) const;
+    void rebuildVisibleRows();
+    QList<int> visibleAmong(const CallRecordColumns &records, int first) const;
+    void appendSourceRows(const CallRecordColumns &records);
+    void removeSourceRows(const QList<int> &sortedRows);
+};
+
+#endif // CALLRECORDMODEL_H
@@ -0,0 +1,86 @@
+#include "callrecordwriter.h"
+#include "perfmonitor.h"
+#include <QSaveFile>
+#include <QThread>
+
+namespace {
+
+// Строк в одном блоке; за раз форматируется по блоку на поток
+constexpr int RowsPerBlock = 65536;
+
+void appendNumber(QByteArray &out, quint32 value)
+{
+    char digits[10];
+    int count = 0;
+    do {
+        digits[count++] = char('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    while (count > 0)
+        out.append(digits[--count]);
+}
+
+}
+
+void CallRecordWriter::appendRecord(QByteArray &out, const CallRecordColumns &columns, const QList<QByteArray> &names, int row)
+{
+    out.append(names.at(columns.surnameIds.at(row)));
+    out.append(',');
+    appendNumber(out, quint32(columns.durations.at(row)));
+    out.append(',');
+    CallRecord::appendIpv4(out, columns.ips.at(row));
+    out.append('\n');
+}
+
+void CallRecordWriter::save(QPromise<QString> &promise, const CallRecordColumns &columns, const QString &filename)
+{
+    PerfMonitor::Scope scope("save", columns.size());
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        promise.addResult(file.errorString());
+        return;
+    }
+
+    // Каждая фамилия кодируется в UTF-8 один раз, строки только копируют байты
+    const QList<QByteArray> names = SurnameDictionary::shared().utf8Texts();
+    const int size = columns.size();
+    const int blocksPerPass = qMax(1, QThread::idealThreadCount());
+    promise.setProgressRange(0, size);
+
+    for (int begin = 0; begin < size; begin += RowsPerBlock * blocksPerPass) {
+        if (promise.isCanceled()) {
+            file.cancelWriting();
+            promise.addResult(QString("Сохранение отменено"));
+            return;
+        }
+
+        const int end = qMin(size, begin + RowsPerBlock * blocksPerPass);
+        QList<QPair<int, int>> blocks;
+        for (int first = begin; first < end; first += RowsPerBlock)
+            blocks.append({first, qMin(end, first + RowsPerBlock)});
+
+        QList<QByteArray> buffers(blocks.size());
+        CallRecord::forEachPartition(blocks, [&](int block, int first, int last) {
+            QByteArray &out = buffers[block];
+            out.reserve(qsizetype(last - first) * 48);
+            for (int row = first; row < last; ++row)
+                appendRecord(out, columns, names, row);
+        });
+
+        for (const QByteArray &buffer : buffers) {
+            if (file.write(buffer) != buffer.size()) {
+                const QString error = file.errorString();
+                file.cancelWriting();
+                promise.addResult(error);
+                return;
+            }
+        }
+        promise.setProgressValue(end);
+    }
+
+    if (!file.commit()) {
+        promise.addResult(file.errorString());
+        return;
+    }
+    promise.addResult(QString());
+}
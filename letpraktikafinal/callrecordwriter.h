@@ -0,0 +1,22 @@
+#ifndef CALLRECORDWRITER_H
+#define CALLRECORDWRITER_H
+
+#include <QByteArray>
+#include <QPromise>
+#include <QString>
+#include "callrecord.h"
+
+class CallRecordWriter
+{
+public:
+    // Сохраняет снимок через QSaveFile: строки форматируются блоками в
+    // нескольких потоках, блоки пишутся по порядку, файл заменяется только
+    // после успешного commit(). Прогресс — число записанных строк,
+    // результат — текст ошибки (пустой при успехе).
+    static void save(QPromise<QString> &promise, const CallRecordColumns &columns, const QString &filename);
+
+    // names — фамилии словаря в UTF-8, см. SurnameDictionary::utf8Texts()
+    static void appendRecord(QByteArray &out, const CallRecordColumns &columns, const QList<QByteArray> &names, int row);
+};
+
+#endif // CALLRECORDWRITER_H
@@ -0,0 +1,148 @@
+#include "callsorter.h"
+#include "callrecordmodel.h"
+#include <QCollator>
+#include <array>
+#include <algorithm>
+#include <numeric>
+
+namespace {
+
+constexpr quint32 MissingKey = 0xFFFFFFFFu;
+
+using Histogram = std::array<qsizetype, 256>;
+
+// Ранг фамилии в алфавитном порядке по номеру в словаре: строки
+// сравниваются один раз на уникальное значение, дальше сортируются только числа
+QList<quint32> surnameRanks(const CallRecordColumns &columns, const QList<int> &rows)
+{
+    const SurnameDictionary &dictionary = SurnameDictionary::shared();
+    const int dictionarySize = dictionary.size();
+    const QList<QPair<int, int>> ranges = CallRecord::partitions(int(rows.size()));
+    QList<QList<bool>> partial(ranges.size());
+    CallRecord::forEachPartition(ranges, [&](int partition, int begin, int end) {
+        QList<bool> &present = partial[partition];
+        present.resize(dictionarySize, false);
+        for (int i = begin; i < end; ++i)
+            present[columns.surnameIds.at(rows.at(i))] = true;
+    });
+
+    QList<quint32> ids;
+    for (int id = 0; id < dictionarySize; ++id) {
+        for (const QList<bool> &present : partial) {
+            if (present.at(id)) {
+                ids.append(quint32(id));
+                break;
+            }
+        }
+    }
+
+    QStringList names;
+    names.reserve(ids.size());
+    for (quint32 id : ids)
+        names.append(dictionary.text(id));
+    QList<int> order(ids.size());
+    std::iota(order.begin(), order.end(), 0);
+    QCollator collator;
+    collator.setNumericMode(true);
+    std::sort(order.begin(), order.end(), [&](int a, int b) {
+        return collator.compare(names.at(a), names.at(b)) < 0;
+    });
+
+    QList<quint32> ranks(dictionarySize, MissingKey);
+    for (int i = 0; i < order.size(); ++i)
+        ranks[ids.at(order.at(i))] = quint32(i);
+    return ranks;
+}
+
+// Устойчивая сортировка по старшим 32 битам: LSD по байтам, гистограммы и
+// раскладка считаются по диапазонам параллельно. Проходы, где все
+// элементы попадают в одну корзину, пропускаются.
+void radixSortByKey(QList<quint64> &items)
+{
+    const int size = int(items.size());
+    const QList<QPair<int, int>> ranges = CallRecord::partitions(size);
+    QList<quint64> buffer(size);
+    QList<Histogram> counts(ranges.size());
+
+    for (int shift = 32; shift < 64; shift += 8) {
+        const quint64 *source = items.constData();
+        quint64 *target = buffer.data();
+
+        CallRecord::forEachPartition(ranges, [&](int partition, int begin, int end) {
+            Histogram &histogram = counts[partition];
+            histogram.fill(0);
+            for (int i = begin; i < end; ++i)
+                ++histogram[(source[i] >> shift) & 0xFF];
+        });
+
+        QList<Histogram> offsets(ranges.size());
+        qsizetype running = 0;
+        bool trivial = false;
+        for (int bucket = 0; bucket < 256; ++bucket) {
+            qsizetype total = 0;
+            for (int partition = 0; partition < ranges.size(); ++partition) {
+                offsets[partition][bucket] = running + total;
+                total += counts.at(partition)[bucket];
+            }
+            trivial = trivial || total == size;
+            running += total;
+        }
+        if (trivial)
+            continue;
+
+        CallRecord::forEachPartition(ranges, [&](int partition, int begin, int end) {
+            Histogram &offset = offsets[partition];
+            for (int i = begin; i < end; ++i)
+                target[offset[(source[i] >> shift) & 0xFF]++] = source[i];
+        });
+        items.swap(buffer);
+    }
+}
+
+}
+
+QList<int> CallSorter::sortedRows(const CallRecordColumns &columns, const QList<int> &rows, const QList<SortKey> &keys)
+{
+    const int size = int(rows.size());
+    QList<quint64> items(size);
+    for (int i = 0; i < size; ++i)
+        items[i] = quint32(rows.at(i));
+
+    const QList<QPair<int, int>> ranges = CallRecord::partitions(size);
+    for (auto key = keys.crbegin(); key != keys.crend(); ++key) {
+        QList<quint32> ranks;
+        if (key->column == CallRecordModel::LastNameColumn)
+            ranks = surnameRanks(columns, rows);
+
+        const bool descending = key->order == Qt::DescendingOrder;
+        quint64 *data = items.data();
+        CallRecord::forEachPartition(ranges, [&](int, int begin, int end) {
+            for (int i = begin; i < end; ++i) {
+                const int row = int(quint32(data[i]));
+                quint32 value = MissingKey;
+                switch (key->column) {
+                case CallRecordModel::LastNameColumn:
+                    value = ranks.at(columns.surnameIds.at(row));
+                    break;
+                case CallRecordModel::DurationColumn:
+                    if (columns.durations.at(row) != CallRecord::InvalidDuration)
+                        value = quint32(columns.durations.at(row));
+                    break;
+                case CallRecordModel::IpColumn:
+                    value = columns.ips.at(row);
+                    break;
+                }
+                // Пустые и некорректные значения остаются в конце при любом направлении
+                if (descending && value != MissingKey)
+                    value = MissingKey - 1 - value;
+                data[i] = (quint64(value) << 32) | quint32(row);
+            }
+        });
+        radixSortByKey(items);
+    }
+
+    QList<int> sorted(size);
+    for (int i = 0; i < size; ++i)
+        sorted[i] = int(quint32(items.at(i)));
+    return sorted;
+}
@@ -0,0 +1,24 @@
+#ifndef CALLSORTER_H
+#define CALLSORTER_H
+
+#include <QList>
+#include <Qt>
+#include "callrecord.h"
+
+class CallSorter
+{
+public:
+    struct SortKey
+    {
+        int column;
+        Qt::SortOrder order;
+    };
+
+    // Возвращает rows, переставленные по ключам (первый ключ — главный).
+    // Каждый ключ сводится к 32-битному числу и сортируется устойчивой
+    // поразрядной сортировкой от младшего ключа к старшему; сами данные
+    // не перемещаются.
+    static QList<int> sortedRows(const CallRecordColumns &columns, const QList<int> &rows, const QList<SortKey> &keys);
+};
+
+#endif // CALLSORTER_H
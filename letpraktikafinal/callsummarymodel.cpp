@@ -0,0 +1,70 @@
+#include "callsummarymodel.h"
+
+namespace {
+
+// Хватает на несколько экранов строк
+constexpr int CacheSize = 512;
+
+}
+
+CallSummaryModel::CallSummaryModel(CallRecordModel *records, QObject *parent)
+    : QAbstractListModel(parent)
+    , records(records)
+    , formatted(CacheSize)
+{
+    // Правка ячейки таблицы меняет текст уже показанных строк
+    connect(records, &QAbstractItemModel::dataChanged, this, &CallSummaryModel::invalidate);
+    rows = records->recordCount();
+}
+
+int CallSummaryModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : rows;
+}
+
+QVariant CallSummaryModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || role != Qt::DisplayRole)
+        return QVariant();
+
+    const int row = index.row();
+    if (const QString *text = formatted.object(row))
+        return *text;
+
+    const CallRecordColumns &columns = records->columns();
+    QString *text = new QString(QString("%1 - %2 мин - %3")
+                                    .arg(columns.lastName(row))
+                                    .arg(columns.durations.at(row))
+                                    .arg(columns.ipText(row)));
+    formatted.insert(row, text);
+    return *text;
+}
+
+void CallSummaryModel::refresh()
+{
+    beginResetModel();
+    formatted.clear();
+    rows = records->recordCount();
+    endResetModel();
+}
+
+void CallSummaryModel::appendRows()
+{
+    const int count = records->recordCount();
+    if (count < rows) {
+        refresh();
+        return;
+    }
+    if (count == rows)
+        return;
+    beginInsertRows(QModelIndex(), rows, count - 1);
+    rows = count;
+    endInsertRows();
+}
+
+void CallSummaryModel::invalidate()
+{
+    formatted.clear();
+    if (rows > 0)
+        emit dataChanged(index(0), index(rows - 1), {Qt::DisplayRole});
+}
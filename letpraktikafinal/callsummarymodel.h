@@ -0,0 +1,35 @@
+#ifndef CALLSUMMARYMODEL_H
+#define CALLSUMMARYMODEL_H
+
+#include <QAbstractListModel>
+#include <QCache>
+#include "callrecordmodel.h"
+
+// Список "фамилия - N мин - IP" поверх записей таблицы. Строки не хранятся:
+// data() форматирует только запрошенные представлением, последние
+// несколько сотен держатся в кэше.
+class CallSummaryModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    explicit CallSummaryModel(CallRecordModel *records, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    // Число строк и содержимое берутся заново из таблицы
+    void refresh();
+    // Записи дописаны в конец таблицы: добавляются только новые строки,
+    // кэш и положение представления сохраняются
+    void appendRows();
+
+private:
+    CallRecordModel *records;
+    mutable QCache<int, QString> formatted;
+    int rows = 0;
+
+    void invalidate();
+};
+
+#endif // CALLSUMMARYMODEL_H
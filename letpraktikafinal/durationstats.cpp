@@ -0,0 +1,114 @@
+#include "durationstats.h"
+#include <QtAlgorithms>
+#include <cmath>
+
+namespace {
+
+// Верхние границы корзин гистограммы, мин
+constexpr std::array<qint32, DurationStats::HistogramBuckets - 1> HistogramBounds = {1, 2, 5, 10, 15, 30, 60, 120};
+
+}
+
+int DurationStats::sketchIndex(qint32 duration)
+{
+    constexpr int linear = 2 << SubBucketBits;
+    if (duration < linear)
+        return duration;
+
+    const int msb = 31 - int(qCountLeadingZeroBits(quint32(duration)));
+    const int shift = msb - SubBucketBits;
+    return linear + (shift - 1) * (1 << SubBucketBits) + ((duration >> shift) - (1 << SubBucketBits));
+}
+
+int DurationStats::histogramIndex(qint32 duration)
+{
+    int bucket = 0;
+    while (bucket < int(HistogramBounds.size()) && duration >= HistogramBounds[bucket])
+        ++bucket;
+    return bucket;
+}
+
+QString DurationStats::histogramLabel(int bucket)
+{
+    if (bucket == 0)
+        return QString("< %1").arg(HistogramBounds.front());
+    if (bucket >= int(HistogramBounds.size()))
+        return QString(">= %1").arg(HistogramBounds.back());
+    return QString("%1-%2").arg(HistogramBounds[bucket - 1]).arg(HistogramBounds[bucket]);
+}
+
+void DurationStats::add(qint32 duration)
+{
+    if (duration < 0)
+        return;
+    ++sketch[sketchIndex(duration)];
+    ++histogram[histogramIndex(duration)];
+    ++total;
+    durationSum += duration;
+}
+
+void DurationStats::remove(qint32 duration)
+{
+    if (duration < 0)
+        return;
+    --sketch[sketchIndex(duration)];
+    --histogram[histogramIndex(duration)];
+    --total;
+    durationSum -= duration;
+}
+
+void DurationStats::merge(const DurationStats &other)
+{
+    for (int i = 0; i < SketchBuckets; ++i)
+        sketch[i] += other.sketch[i];
+    for (int i = 0; i < HistogramBuckets; ++i)
+        histogram[i] += other.histogram[i];
+    total += other.total;
+    durationSum += other.durationSum;
+}
+
+void DurationStats::clear()
+{
+    *this = DurationStats();
+}
+
+qint32 DurationStats::quantile(double q) const
+{
+    if (total == 0)
+        return 0;
+
+    const qint64 rank = qBound<qint64>(1, qint64(std::ceil(q * double(total))), total);
+    qint64 seen = 0;
+    int index = 0;
+    for (; index < SketchBuckets; ++index) {
+        seen += sketch[index];
+        if (seen >= rank)
+            break;
+    }
+
+    constexpr int linear = 2 << SubBucketBits;
+    if (index < linear)
+        return index;
+    // Середина лог-линейной корзины
+    const int shift = (index - linear) / (1 << SubBucketBits) + 1;
+    const qint64 sub = (index - linear) % (1 << SubBucketBits) + (1 << SubBucketBits);
+    const qint64 low = sub << shift;
+    const qint64 high = ((sub + 1) << shift) - 1;
+    return qint32((low + high) / 2);
+}
+
+DurationStats DurationStats::fromColumns(const CallRecordColumns &columns)
+{
+    const QList<QPair<int, int>> ranges = CallRecord::partitions(columns.size());
+    QList<DurationStats> partial(ranges.size());
+    CallRecord::forEachPartition(ranges, [&](int partition, int begin, int end) {
+        DurationStats &stats = partial[partition];
+        for (int row = begin; row < end; ++row)
+            stats.add(columns.durations.at(row));
+    });
+
+    DurationStats stats;
+    for (const DurationStats &part : partial)
+        stats.merge(part);
+    return stats;
+}
@@ -0,0 +1,46 @@
+#ifndef DURATIONSTATS_H
+#define DURATIONSTATS_H
+
+#include <QString>
+#include <array>
+#include "callrecord.h"
+
+// Распределение времени разговора в постоянной памяти. Квантили считаются
+// по лог-линейным корзинам (до 64 мин — точно, дальше 32 корзины на
+// каждую степень двойки, погрешность не больше 1/64). В отличие от
+// t-digest и KLL, счётчики можно уменьшать, поэтому удаление строк
+// учитывается точно; наборы сливаются сложением.
+class DurationStats
+{
+public:
+    static constexpr int HistogramBuckets = 9;
+
+    void add(qint32 duration);
+    void remove(qint32 duration);
+    void merge(const DurationStats &other);
+    void clear();
+
+    qint64 count() const { return total; }
+    qint64 sum() const { return durationSum; }
+    qint32 quantile(double q) const;
+
+    qint64 histogramCount(int bucket) const { return histogram.at(bucket); }
+    static QString histogramLabel(int bucket);
+
+    // Считается по диапазонам в нескольких потоках, частичные результаты сливаются
+    static DurationStats fromColumns(const CallRecordColumns &columns);
+
+private:
+    static constexpr int SubBucketBits = 5;
+    static constexpr int SketchBuckets = 864;
+
+    std::array<qint64, SketchBuckets> sketch {};
+    std::array<qint64, HistogramBuckets> histogram {};
+    qint64 total = 0;
+    qint64 durationSum = 0;
+
+    static int sketchIndex(qint32 duration);
+    static int histogramIndex(qint32 duration);
+};
+
+#endif // DURATIONSTATS_H
@@ -0,0 +1,82 @@
+#include "imageloader.h"
+#include <QDateTime>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QImageReader>
+#include <QtConcurrent>
+
+namespace {
+
+// Лимит кэша в килобайтах
+constexpr int CacheLimit = 64 * 1024;
+// Запас при декодировании, чтобы небольшое увеличение окна не требовало нового чтения файла
+constexpr double DecodeHeadroom = 1.5;
+
+}
+
+ImageLoader::ImageLoader(QObject *parent)
+    : QObject(parent)
+{
+    cache.setMaxCost(CacheLimit);
+}
+
+QString ImageLoader::cacheKey(const QString &path)
+{
+    const QFileInfo info(path);
+    return QString("%1|%2").arg(info.absoluteFilePath()).arg(info.lastModified().toMSecsSinceEpoch());
+}
+
+ImageLoader::Decoded ImageLoader::decode(const QString &path, const QSize &targetSize)
+{
+    QImageReader reader(path);
+    reader.setAutoTransform(true);
+
+    Decoded decoded;
+    QSize bound = targetSize;
+    // Поворот применяется после декодирования, поэтому ограничение задаётся до него
+    if (reader.transformation().testFlag(QImageIOHandler::TransformationRotate90))
+        bound.transpose();
+
+    const QSize original = reader.size();
+    if (original.isValid() && !bound.isEmpty()
+        && (original.width() > bound.width() || original.height() > bound.height())) {
+        reader.setScaledSize(original.scaled(bound, Qt::KeepAspectRatio));
+    } else {
+        decoded.fullResolution = true;
+    }
+    decoded.image = reader.read();
+    return decoded;
+}
+
+bool ImageLoader::load(const QString &path, const QSize &targetSize)
+{
+    const QString key = cacheKey(path);
+    if (const Decoded *cached = cache.object(key)) {
+        const QSize size = cached->image.size();
+        if (cached->fullResolution || size.width() >= targetSize.width() || size.height() >= targetSize.height()) {
+            ++generation;
+            emit imageLoaded(path, cached->image);
+            return true;
+        }
+    }
+
+    const quint64 request = ++generation;
+    const QSize decodeSize = targetSize * DecodeHeadroom;
+    auto *watcher = new QFutureWatcher<Decoded>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, request, key, path]() {
+        const Decoded decoded = watcher->result();
+        watcher->deleteLater();
+
+        if (!decoded.image.isNull())
+            cache.insert(key, new Decoded(decoded), int(qMax<qsizetype>(1, decoded.image.sizeInBytes() / 1024)));
+        // Пока картинка декодировалась, могли запросить другую
+        if (request != generation)
+            return;
+        if (decoded.image.isNull())
+            emit loadFailed(path);
+        else
+            emit imageLoaded(path, decoded.image);
+    });
+    watcher->setFuture(QtConcurrent::run(&ImageLoader::decode, path, decodeSize));
+    return false;
+}
@@ -0,0 +1,41 @@
+#ifndef IMAGELOADER_H
+#define IMAGELOADER_H
+
+#include <QObject>
+#include <QCache>
+#include <QImage>
+#include <QSize>
+#include <QString>
+
+// Загрузка изображений в фоне: QImageReader сразу декодирует картинку в
+// размере отображения, результат кладётся в LRU-кэш (путь + время изменения)
+class ImageLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ImageLoader(QObject *parent = nullptr);
+
+    // Если в кэше есть достаточно крупная копия, сигнал придёт сразу
+    // и вернётся true; иначе картинка декодируется в фоне
+    bool load(const QString &path, const QSize &targetSize);
+
+signals:
+    void imageLoaded(const QString &path, const QImage &image);
+    void loadFailed(const QString &path);
+
+private:
+    struct Decoded
+    {
+        QImage image;
+        bool fullResolution = false;
+    };
+
+    QCache<QString, Decoded> cache;
+    quint64 generation = 0;
+
+    static QString cacheKey(const QString &path);
+    static Decoded decode(const QString &path, const QSize &targetSize);
+};
+
+#endif // IMAGELOADER_H
@@ -0,0 +1,295 @@
+#include "ipprefixindex.h"
+#include "callrecord.h"
+#include <QtAlgorithms>
+#include <algorithm>
+
+namespace {
+
+quint32 prefixMask(int length)
+{
+    return length <= 0 ? 0 : ~quint32(0) << (32 - length);
+}
+
+int bitAt(quint32 ip, int position)
+{
+    return int((ip >> (31 - position)) & 1);
+}
+
+int commonPrefixLength(quint32 a, quint32 b)
+{
+    const quint32 diff = a ^ b;
+    return diff == 0 ? 32 : int(qCountLeadingZeroBits(diff));
+}
+
+}
+
+void IpPrefixIndex::clear()
+{
+    nodes.clear();
+    freeNodes.clear();
+    root = -1;
+    leafCount = 0;
+}
+
+void IpPrefixIndex::build(const QList<quint32> &ips)
+{
+    clear();
+    for (int row = 0; row < ips.size(); ++row) {
+        if (ips.at(row) != CallRecord::InvalidIp)
+            insert(ips.at(row), row);
+    }
+}
+
+int IpPrefixIndex::newNode(quint32 key, int length)
+{
+    Node node;
+    node.key = key;
+    node.length = length;
+    if (!freeNodes.isEmpty()) {
+        const int index = freeNodes.takeLast();
+        nodes[index] = node;
+        return index;
+    }
+    nodes.append(node);
+    return int(nodes.size() - 1);
+}
+
+void IpPrefixIndex::releaseNode(int node)
+{
+    nodes[node] = Node();
+    freeNodes.append(node);
+}
+
+void IpPrefixIndex::insert(quint32 ip, int row)
+{
+    int leaf = -1;
+    if (root < 0) {
+        root = leaf = newNode(ip, 32);
+        ++leafCount;
+    } else {
+        int parent = -1;
+        int side = 0;
+        int node = root;
+        while (leaf < 0) {
+            const int length = nodes[node].length;
+            const int common = qMin(length, commonPrefixLength(ip, nodes[node].key));
+            if (common < length) {
+                // Адрес расходится с узлом раньше конца его префикса — вставляем развилку
+                leaf = newNode(ip, 32);
+                const int split = newNode(ip & prefixMask(common), common);
+                const int bit = bitAt(ip, common);
+                nodes[split].child[bit] = leaf;
+                nodes[split].child[1 - bit] = node;
+                if (parent < 0)
+                    root = split;
+                else
+                    nodes[parent].child[side] = split;
+                ++leafCount;
+            } else if (length == 32) {
+                leaf = node;
+            } else {
+                const int bit = bitAt(ip, length);
+                if (nodes[node].child[bit] < 0) {
+                    leaf = newNode(ip, 32);
+                    nodes[node].child[bit] = leaf;
+                    ++leafCount;
+                } else {
+                    parent = node;
+                    side = bit;
+                    node = nodes[node].child[bit];
+                }
+            }
+        }
+    }
+
+    QList<int> &rows = nodes[leaf].rows;
+    if (rows.isEmpty() || rows.constLast() < row)
+        rows.append(row);
+    else
+        rows.insert(std::lower_bound(rows.begin(), rows.end(), row) - rows.begin(), row);
+}
+
+void IpPrefixIndex::remove(quint32 ip, int row)
+{
+    int grandParent = -1;
+    int grandSide = 0;
+    int parent = -1;
+    int side = 0;
+    int node = root;
+    while (node >= 0 && nodes[node].length < 32) {
+        const Node &current = nodes[node];
+        if ((ip & prefixMask(current.length)) != current.key)
+            return;
+        grandParent = parent;
+        grandSide = side;
+        parent = node;
+        side = bitAt(ip, current.length);
+        node = current.child[side];
+    }
+    if (node < 0 || nodes[node].key != ip)
+        return;
+
+    QList<int> &rows = nodes[node].rows;
+    const auto it = std::lower_bound(rows.begin(), rows.end(), row);
+    if (it == rows.end() || *it != row)
+        return;
+    rows.erase(it);
+    if (!rows.isEmpty())
+        return;
+
+    // Лист опустел: убираем его, а развилку над ним заменяем вторым потомком
+    if (parent < 0) {
+        root = -1;
+    } else {
+        const int sibling = nodes[parent].child[1 - side];
+        if (grandParent < 0)
+            root = sibling;
+        else
+            nodes[grandParent].child[grandSide] = sibling;
+        releaseNode(parent);
+    }
+    releaseNode(node);
+    --leafCount;
+}
+
+void IpPrefixIndex::shiftRows(const QList<int> &removedRows)
+{
+    if (removedRows.isEmpty())
+        return;
+
+    for (Node &node : nodes) {
+        for (int &row : node.rows) {
+            if (row > removedRows.constFirst())
+                row -= int(std::lower_bound(removedRows.cbegin(), removedRows.cend(), row) - removedRows.cbegin());
+        }
+    }
+}
+
+void IpPrefixIndex::collect(int node, QList<int> &rows) const
+{
+    if (node < 0)
+        return;
+    const Node &current = nodes.at(node);
+    if (current.length == 32) {
+        rows.append(current.rows);
+        return;
+    }
+    collect(current.child[0], rows);
+    collect(current.child[1], rows);
+}
+
+void IpPrefixIndex::collectRange(int node, quint32 first, quint32 last, QList<int> &rows) const
+{
+    if (node < 0)
+        return;
+    const Node &current = nodes.at(node);
+    const quint32 low = current.key;
+    const quint32 high = current.key | ~prefixMask(current.length);
+    if (high < first || low > last)
+        return;
+    if (first <= low && high <= last) {
+        collect(node, rows);
+        return;
+    }
+    collectRange(current.child[0], first, last, rows);
+    collectRange(current.child[1], first, last, rows);
+}
+
+QList<int> IpPrefixIndex::rowsInPrefix(quint32 prefix, int length) const
+{
+    const quint32 mask = prefixMask(length);
+    prefix &= mask;
+
+    QList<int> rows;
+    int node = root;
+    while (node >= 0) {
+        const Node &current = nodes.at(node);
+        if (current.length >= length) {
+            if ((current.key & mask) == prefix)
+                collect(node, rows);
+            break;
+        }
+        if ((prefix & prefixMask(current.length)) != current.key)
+            break;
+        node = current.child[bitAt(prefix, current.length)];
+    }
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+QList<int> IpPrefixIndex::rowsInRange(quint32 first, quint32 last) const
+{
+    QList<int> rows;
+    collectRange(root, first, last, rows);
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+bool IpPrefixIndex::parseQuery(QStringView text, quint32 *first, quint32 *last)
+{
+    text = text.trimmed();
+    if (text.isEmpty())
+        return false;
+
+    const qsizetype dash = text.indexOf(u'-');
+    if (dash >= 0) {
+        const quint32 from = CallRecord::parseIpv4(text.left(dash));
+        const quint32 to = CallRecord::parseIpv4(text.mid(dash + 1));
+        if (from == CallRecord::InvalidIp || to == CallRecord::InvalidIp)
+            return false;
+        *first = qMin(from, to);
+        *last = qMax(from, to);
+        return true;
+    }
+
+    int length = -1;
+    const qsizetype slash = text.indexOf(u'/');
+    if (slash >= 0) {
+        bool ok = false;
+        length = text.mid(slash + 1).trimmed().toInt(&ok);
+        if (!ok || length < 0 || length > 32)
+            return false;
+        text = text.left(slash).trimmed();
+    }
+
+    // Неполный адрес ("10.20" или "10.20.") задаёт префикс из введённых октетов
+    quint32 prefix = 0;
+    int octets = 0;
+    int value = -1;
+    for (QChar c : text) {
+        const char16_t u = c.unicode();
+        if (u >= u'0' && u <= u'9') {
+            value = (value < 0 ? 0 : value) * 10 + (u - u'0');
+            if (value > 255)
+                return false;
+        } else if (u == u'.' && value >= 0 && octets < 3) {
+            prefix = (prefix << 8) | quint32(value);
+            ++octets;
+            value = -1;
+        } else {
+            return false;
+        }
+    }
+    if (value >= 0) {
+        prefix = (prefix << 8) | quint32(value);
+        ++octets;
+    }
+    if (octets == 0)
+        return false;
+    prefix <<= 8 * (4 - octets);
+    if (length < 0)
+        length = 8 * octets;
+
+    const quint32 mask = prefixMask(length);
+    *first = prefix & mask;
+    *last = (prefix & mask) | ~mask;
+    return true;
+}
+
+qsizetype IpPrefixIndex::memoryUsage() const
+{
+    qsizetype bytes = nodes.capacity() * qsizetype(sizeof(Node)) + freeNodes.capacity() * qsizetype(sizeof(int));
+    for (const Node &node : nodes)
+        bytes += node.rows.capacity() * qsizetype(sizeof(int));
+    return bytes;
+}
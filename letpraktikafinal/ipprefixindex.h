@@ -0,0 +1,51 @@
+#ifndef IPPREFIXINDEX_H
+#define IPPREFIXINDEX_H
+
+#include <QList>
+#include <QStringView>
+
+// Сжатое двоичное дерево (Patricia) по IPv4 адресам. В листьях хранятся
+// номера строк с этим адресом. Поиск по префиксу и диапазону обходит
+// только подходящие поддеревья, поэтому время пропорционально ответу.
+class IpPrefixIndex
+{
+public:
+    void clear();
+    void build(const QList<quint32> &ips);
+
+    void insert(quint32 ip, int row);
+    void remove(quint32 ip, int row);
+    // removedRows отсортированы и уже удалены из индекса через remove()
+    void shiftRows(const QList<int> &removedRows);
+
+    QList<int> rowsInPrefix(quint32 prefix, int length) const;
+    QList<int> rowsInRange(quint32 first, quint32 last) const;
+
+    int addressCount() const { return leafCount; }
+    int nodeCount() const { return int(nodes.size() - freeNodes.size()); }
+    qsizetype memoryUsage() const;
+
+    // "10.20.0.0/16", "10.20." или "10.0.0.1-10.0.0.99"
+    static bool parseQuery(QStringView text, quint32 *first, quint32 *last);
+
+private:
+    struct Node
+    {
+        quint32 key = 0;
+        int length = 0;
+        int child[2] = {-1, -1};
+        QList<int> rows;
+    };
+
+    QList<Node> nodes;
+    QList<int> freeNodes;
+    int root = -1;
+    int leafCount = 0;
+
+    int newNode(quint32 key, int length);
+    void releaseNode(int node);
+    void collect(int node, QList<int> &rows) const;
+    void collectRange(int node, quint32 first, quint32 last, QList<int> &rows) const;
+};
+
+#endif // IPPREFIXINDEX_H
@@ -1,4 +1,4 @@
-QT       += core gui
+QT       += core gui concurrent
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
@@ -9,11 +9,45 @@ CONFIG += c++17
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
+    aggregateresultmodel.cpp \
+    callaggregator.cpp \
+    calllogfollower.cpp \
+    callrecord.cpp \
+    callrecordimporter.cpp \
+    callrecordmodel.cpp \
+    callrecordwriter.cpp \
+    callsorter.cpp \
+    callsummarymodel.cpp \
+    durationstats.cpp \
+    imageloader.cpp \
+    ipprefixindex.cpp \
     main.cpp \
-    mainwindow.cpp
+    mainwindow.cpp \
+    perfmonitor.cpp \
+    surnamedictionary.cpp \
+    surnameindex.cpp \
+    surnamelistmodel.cpp \
+    textlistmodel.cpp
 
 HEADERS += \
-    mainwindow.h
+    aggregateresultmodel.h \
+    callaggregator.h \
+    calllogfollower.h \
+    callrecord.h \
+    callrecordimporter.h \
+    callrecordmodel.h \
+    callrecordwriter.h \
+    callsorter.h \
+    callsummarymodel.h \
+    durationstats.h \
+    imageloader.h \
+    ipprefixindex.h \
+    mainwindow.h \
+    perfmonitor.h \
+    surnamedictionary.h \
+    surnameindex.h \
+    surnamelistmodel.h \
+    textlistmodel.h
 
 FORMS += \
     mainwindow.ui
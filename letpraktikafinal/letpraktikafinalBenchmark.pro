@@ -0,0 +1,39 @@
+TEMPLATE = app
+TARGET = letpraktikafinalBenchmark
+QT += core gui widgets concurrent
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+# Запуск: ./letpraktikafinalBenchmark --rows 10000,100000,1000000 -o results.json
+
+SOURCES += \
+    benchmarkmain.cpp \
+    callbenchmark.cpp \
+    callrecord.cpp \
+    callrecordimporter.cpp \
+    callrecordmodel.cpp \
+    callrecordwriter.cpp \
+    callsorter.cpp \
+    callsummarymodel.cpp \
+    durationstats.cpp \
+    ipprefixindex.cpp \
+    perfmonitor.cpp \
+    surnamedictionary.cpp \
+    surnameindex.cpp \
+    surnamelistmodel.cpp
+
+HEADERS += \
+    callbenchmark.h \
+    callrecord.h \
+    callrecordimporter.h \
+    callrecordmodel.h \
+    callrecordwriter.h \
+    callsorter.h \
+    callsummarymodel.h \
+    durationstats.h \
+    ipprefixindex.h \
+    perfmonitor.h \
+    surnamedictionary.h \
+    surnameindex.h \
+    surnamelistmodel.h
@@ -1,12 +1,14 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
-#include <QFile>
-#include <QTextStream>
 #include <QInputDialog>
 #include <QMessageBox>
 #include <QFileDialog>
+#include <QFileInfo>
 #include <QPixmap>
 #include <QKeyEvent>
+#include <QHeaderView>
+#include <QFontDatabase>
+#include <QtConcurrent>
 #include <algorithm>
 
 MainWindow::MainWindow(QWidget *parent)
@@ -16,52 +18,117 @@ MainWindow::MainWindow(QWidget *parent)
     ui->setupUi(this);
 
     // Настройка таблицы
-    ui->tableWidget->setColumnCount(3);
-    ui->tableWidget->setHorizontalHeaderLabels({"Фамилия", "Время разговора", "IP адрес"});
-    ui->tableWidget->setSelectionBehavior(QAbstractItemView::SelectRows);
-
-    // Настройка списка
-    ui->listWidget->setSelectionMode(QAbstractItemView::SingleSelection);
+    callModel = new CallRecordModel(this);
+    ui->tableView->setModel(callModel);
+    ui->tableView->setSelectionBehavior(QAbstractItemView::SelectRows);
+    ui->tableView->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    ui->tableView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    // Сортировка по щелчку на заголовке; предыдущие столбцы остаются дополнительными ключами
+    ui->tableView->horizontalHeader()->setSortIndicator(-1, Qt::AscendingOrder);
+    ui->tableView->setSortingEnabled(true);
+
+    // Настройка списка: строки в модели, порядок сортировки считается в фоне
+    textListModel = new TextListModel(this);
+    ui->textListView->setModel(textListModel);
+    ui->textListView->setSelectionMode(QAbstractItemView::SingleSelection);
+    ui->textListView->setUniformItemSizes(true);
+    listSortWatcher = new QFutureWatcher<QList<int>>(this);
+    connect(listSortWatcher, &QFutureWatcherBase::finished, this, &MainWindow::applyListOrder);
 
     // Настройка ComboBox
-    comboModel = new QStringListModel(this);
+    comboModel = new SurnameListModel(callModel, this);
     ui->comboBox->setModel(comboModel);
+    // Ширина по содержимому потребовала бы обойти все записи
+    ui->comboBox->setSizeAdjustPolicy(QComboBox::AdjustToMinimumContentsLengthWithIcon);
+    ui->comboBox->setMinimumContentsLength(20);
+    if (QListView *popup = qobject_cast<QListView *>(ui->comboBox->view()))
+        popup->setUniformItemSizes(true);
     updateComboBox();
 
-    // Настройка ListView
-    updateListView();
+    // Настройка ListView: строки форматируются только при отрисовке
+    summaryModel = new CallSummaryModel(callModel, this);
+    ui->listView->setModel(summaryModel);
+    ui->listView->setUniformItemSizes(true);
 
     // Контекстное меню для списка
     contextMenu = new QMenu(this);
-    contextMenu->addAction("Удалить", this, [this]() {
-        if (ui->listWidget->currentRow() >= 0) {
-            delete ui->listWidget->takeItem(ui->listWidget->currentRow());
-        }
-    });
+    contextMenu->addAction("Удалить", this, &MainWindow::on_removeListButton_clicked);
 
     // Контекстное меню для таблицы
     tableContextMenu = new QMenu(this);
-    tableContextMenu->addAction("Удалить строку", this, [this]() {
-        if (ui->tableWidget->currentRow() >= 0) {
-            ui->tableWidget->removeRow(ui->tableWidget->currentRow());
-            updateComboBox();
-            updateListView();
-            updateArraySize();
-        }
-    });
+    tableContextMenu->addAction("Удалить выделенные строки", this, &MainWindow::removeSelectedRows);
 
     // Подключение обработчиков правой кнопки мыши
-    connect(ui->listWidget, &QListWidget::customContextMenuRequested, this, &MainWindow::handleRightClick);
-    connect(ui->tableWidget, &QTableWidget::customContextMenuRequested, this, &MainWindow::handleTableRightClick);
+    connect(ui->textListView, &QListView::customContextMenuRequested, this, &MainWindow::handleRightClick);
+    connect(ui->tableView, &QTableView::customContextMenuRequested, this, &MainWindow::handleTableRightClick);
 
     // Установка контекстного меню
-    ui->listWidget->setContextMenuPolicy(Qt::CustomContextMenu);
-    ui->tableWidget->setContextMenuPolicy(Qt::CustomContextMenu);
+    ui->textListView->setContextMenuPolicy(Qt::CustomContextMenu);
+    ui->tableView->setContextMenuPolicy(Qt::CustomContextMenu);
 
     // Настройка отображения размера массива
     arraySizeLabel = new QLabel(this);
     ui->statusbar->addWidget(arraySizeLabel);
+    indexSizeLabel = new QLabel(this);
+    ui->statusbar->addPermanentWidget(indexSizeLabel);
     updateArraySize();
+
+    // Панель производительности (меню "Отладка"), по умолчанию скрыта
+    perfLabel = new QLabel(this);
+    perfLabel->setVisible(false);
+    ui->statusbar->addPermanentWidget(perfLabel);
+    perfTimer = new QTimer(this);
+    perfTimer->setInterval(500);
+    connect(perfTimer, &QTimer::timeout, this, &MainWindow::updatePerfPanel);
+
+    // Группировка записей
+    ui->groupByComboBox->addItem("По фамилии", CallAggregator::BySurname);
+    ui->groupByComboBox->addItem("По IP адресу", CallAggregator::ByIp);
+    ui->groupByComboBox->addItem("По подсети", CallAggregator::BySubnet);
+    connect(ui->groupByComboBox, &QComboBox::currentIndexChanged, this, [this]() {
+        ui->prefixSpinBox->setEnabled(ui->groupByComboBox->currentData().toInt() == CallAggregator::BySubnet);
+    });
+    ui->prefixSpinBox->setEnabled(false);
+    aggregateModel = new AggregateResultModel(this);
+    ui->aggregateView->setModel(aggregateModel);
+    ui->aggregateView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    aggregateWatcher = new QFutureWatcher<QList<CallAggregator::Group>>(this);
+    connect(aggregateWatcher, &QFutureWatcherBase::finished, this, &MainWindow::showAggregateResult);
+
+    // Изображение декодируется в фоне; размер метки не зависит от картинки
+    imageLoader = new ImageLoader(this);
+    connect(imageLoader, &ImageLoader::imageLoaded, this, &MainWindow::showImage);
+    connect(imageLoader, &ImageLoader::loadFailed, this, [this]() {
+        imagePath.clear();
+        QMessageBox::warning(this, "Ошибка", "Не удалось загрузить изображение");
+    });
+    ui->imageLabel->setSizePolicy(QSizePolicy::Ignored, QSizePolicy::Ignored);
+    ui->imageLabel->installEventFilter(this);
+
+    // Сохранение выполняется в фоне
+    saveWatcher = new QFutureWatcher<QString>(this);
+    connect(saveWatcher, &QFutureWatcherBase::progressValueChanged, this, &MainWindow::showSaveProgress);
+    connect(saveWatcher, &QFutureWatcherBase::finished, this, &MainWindow::finishSave);
+
+    // Режим слежения за дописываемым файлом
+    logFollower = new CallLogFollower(this);
+    connect(logFollower, &CallLogFollower::recordsAppended, this, &MainWindow::appendFollowedRecords);
+    connect(logFollower, &CallLogFollower::fileRestarted, this, [this]() {
+        ui->statusbar->showMessage("Файл усечён или заменён, чтение с начала", 5000);
+    });
+    // Подробности об отклонённых строках — после остановки слежения
+    connect(logFollower, &CallLogFollower::linesRejected, this, [this](qint64 total) {
+        ui->statusbar->showMessage(QString("Не принято строк: %1").arg(total), 5000);
+    });
+
+    // Панель статистики по времени разговора
+    ui->statsLabel->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
+    connect(callModel, &CallRecordModel::statisticsChanged, this, &MainWindow::updateStatistics);
+    updateStatistics();
+
+    // Загрузка нескольких файлов в фоне
+    importWatcher = new QFutureWatcher<CallRecordImporter::Result>(this);
+    connect(importWatcher, &QFutureWatcherBase::finished, this, &MainWindow::finishImport);
 }
 
 MainWindow::~MainWindow()
@@ -71,22 +138,23 @@ MainWindow::~MainWindow()
 
 void MainWindow::updateArraySize()
 {
-    int size = ui->tableWidget->rowCount();
-    arraySizeLabel->setText(QString("Записей: %1").arg(size));
+    int size = callModel->recordCount();
+    if (callModel->isFiltered()) {
+        arraySizeLabel->setText(QString("Записей: %1 (показано %2)").arg(size).arg(callModel->rowCount()));
+    } else {
+        arraySizeLabel->setText(QString("Записей: %1").arg(size));
+    }
+
+    const SurnameIndex &index = callModel->surnameIndex();
+    indexSizeLabel->setText(QString("Фамилий: %1, словарь: %2 КБ, индекс: %3 КБ")
+                                .arg(index.nameCount())
+                                .arg((SurnameDictionary::shared().memoryUsage() + 1023) / 1024)
+                                .arg((index.memoryUsage() + 1023) / 1024));
 }
 
 void MainWindow::on_addButton_clicked()
 {
-    int row = ui->tableWidget->rowCount();
-    ui->tableWidget->insertRow(row);
-
-    QTableWidgetItem *lastNameItem = new QTableWidgetItem("Иванов");
-    QTableWidgetItem *timeItem = new QTableWidgetItem("30");
-    QTableWidgetItem *ipItem = new QTableWidgetItem("192.168.1.1");
-
-    ui->tableWidget->setItem(row, 0, lastNameItem);
-    ui->tableWidget->setItem(row, 1, timeItem);
-    ui->tableWidget->setItem(row, 2, ipItem);
+    callModel->appendRecord("Иванов", "30", "192.168.1.1");
 
     updateComboBox();
     updateListView();
@@ -95,13 +163,29 @@ void MainWindow::on_addButton_clicked()
 
 void MainWindow::on_removeButton_clicked()
 {
-    int currentRow = ui->tableWidget->currentRow();
-    if (currentRow >= 0) {
-        ui->tableWidget->removeRow(currentRow);
-        updateComboBox();
-        updateListView();
-        updateArraySize();
-    }
+    removeSelectedRows();
+}
+
+void MainWindow::removeSelectedRows()
+{
+    QList<int> rows;
+    const QModelIndexList selected = ui->tableView->selectionModel()->selectedRows();
+    for (const QModelIndex &index : selected)
+        rows.append(index.row());
+    if (rows.isEmpty() && ui->tableView->currentIndex().isValid())
+        rows.append(ui->tableView->currentIndex().row());
+    if (rows.isEmpty())
+        return;
+
+    // Все строки удаляются одним пакетом, списки обновляются один раз
+    const int first = *std::min_element(rows.cbegin(), rows.cend());
+    callModel->applyChanges(rows);
+    updateComboBox();
+    updateListView();
+    updateArraySize();
+
+    if (callModel->rowCount() > 0)
+        ui->tableView->setCurrentIndex(callModel->index(qMin(first, callModel->rowCount() - 1), 0));
 }
 
 void MainWindow::on_addListButton_clicked()
@@ -109,37 +193,52 @@ void MainWindow::on_addListButton_clicked()
     bool ok;
     QString text = QInputDialog::getText(this, "Добавить элемент", "Введите текст:", QLineEdit::Normal, "", &ok);
     if (ok && !text.isEmpty()) {
-        ui->listWidget->addItem(text);
+        textListModel->appendItem(text);
     }
 }
 
 void MainWindow::on_removeListButton_clicked()
 {
-    if (ui->listWidget->currentRow() >= 0) {
-        delete ui->listWidget->takeItem(ui->listWidget->currentRow());
+    const QModelIndex current = ui->textListView->currentIndex();
+    if (current.isValid()) {
+        textListModel->removeRows(current.row(), 1);
     }
 }
 
 void MainWindow::on_sortListButton_clicked()
 {
-    ui->listWidget->sortItems();
+    sortTextList(TextListModel::LexicalKey);
 }
 
 void MainWindow::on_customSortButton_clicked()
 {
-    QList<QListWidgetItem*> items;
-    for (int i = 0; i < ui->listWidget->count(); ++i) {
-        items.append(ui->listWidget->item(i));
+    sortTextList(TextListModel::LengthKey);
+}
+
+void MainWindow::sortTextList(TextListModel::SortKey key)
+{
+    if (listSortWatcher->isRunning()) {
+        return;
     }
 
-    std::sort(items.begin(), items.end(), [](QListWidgetItem *a, QListWidgetItem *b) {
-        return a->text().length() < b->text().length();
-    });
+    // Порядок считается по снимку строк и применяется, только если список не менялся
+    listSortRevision = textListModel->revision();
+    listSortStart = PerfMonitor::shared().now();
+    const QStringList items = textListModel->items();
+    listSortWatcher->setFuture(QtConcurrent::run([items, key]() {
+        return TextListModel::sortedOrder(items, key);
+    }));
+}
 
-    for (int i = 0; i < items.count(); ++i) {
-        ui->listWidget->insertItem(i, items.at(i)->clone());
-        delete items.at(i);
+void MainWindow::applyListOrder()
+{
+    if (textListModel->revision() != listSortRevision) {
+        ui->statusbar->showMessage("Список изменился во время сортировки, повторите", 5000);
+        return;
     }
+    textListModel->applyOrder(listSortWatcher->result());
+    PerfMonitor &monitor = PerfMonitor::shared();
+    monitor.record("sort.list", listSortStart, monitor.now() - listSortStart, textListModel->rowCount());
 }
 
 void MainWindow::on_loadImageButton_clicked()
@@ -160,44 +259,50 @@ void MainWindow::on_saveButton_clicked()
 
 void MainWindow::on_loadButton_clicked()
 {
-    QString filename = QFileDialog::getOpenFileName(this, "Загрузить данные", "", "Text files (*.txt)");
-    if (!filename.isEmpty()) {
-        loadDataFromFile(filename);
+    QStringList filenames = QFileDialog::getOpenFileNames(this, "Загрузить данные", "", "Text files (*.txt)");
+    if (!filenames.isEmpty()) {
+        loadDataFromFiles(filenames);
     }
 }
 
 void MainWindow::on_loadFromTextButton_clicked()
 {
-    QString text = ui->plainTextEdit->toPlainText();
-    QStringList lines = text.split("\n");
-
-    ui->tableWidget->setRowCount(0);
-    for (const QString &line : lines) {
-        QStringList parts = line.split(",");
-        if (parts.size() == 3) {
-            int row = ui->tableWidget->rowCount();
-            ui->tableWidget->insertRow(row);
-            ui->tableWidget->setItem(row, 0, new QTableWidgetItem(parts[0]));
-            ui->tableWidget->setItem(row, 1, new QTableWidgetItem(parts[1]));
-            ui->tableWidget->setItem(row, 2, new QTableWidgetItem(parts[2]));
-        }
-    }
+    const QByteArray text = ui->plainTextEdit->toPlainText().toUtf8();
+
+    CallRecordColumns columns;
+    CallRecordRejects rejects;
+    columns.appendLines(text, rejects);
+    callModel->setColumns(columns);
     updateComboBox();
     updateListView();
     updateArraySize();
+    showRejects(rejects, {"текст"});
+}
+
+void MainWindow::showRejects(const CallRecordRejects &rejects, const QStringList &sources)
+{
+    if (rejects.total() == 0)
+        return;
+
+    QMessageBox box(QMessageBox::Warning, "Пропущенные строки",
+                    QString("Не принято строк: %1").arg(rejects.total()), QMessageBox::Ok, this);
+    box.setDetailedText(rejects.summary(sources));
+    box.exec();
 }
 
 void MainWindow::handleRightClick(const QPoint &pos)
 {
-    if (ui->listWidget->itemAt(pos)) {
-        contextMenu->exec(ui->listWidget->mapToGlobal(pos));
+    const QModelIndex index = ui->textListView->indexAt(pos);
+    if (index.isValid()) {
+        ui->textListView->setCurrentIndex(index);
+        contextMenu->exec(ui->textListView->viewport()->mapToGlobal(pos));
     }
 }
 
 void MainWindow::handleTableRightClick(const QPoint &pos)
 {
-    if (ui->tableWidget->itemAt(pos)) {
-        tableContextMenu->exec(ui->tableWidget->mapToGlobal(pos));
+    if (ui->tableView->indexAt(pos).isValid()) {
+        tableContextMenu->exec(ui->tableView->viewport()->mapToGlobal(pos));
     }
 }
 
@@ -205,92 +310,306 @@ void MainWindow::keyPressEvent(QKeyEvent *event)
 {
     // Обработка Delete для Mac (обычный Backspace или Fn+Backspace)
     if (event->key() == Qt::Key_Delete || event->key() == Qt::Key_Backspace) {
-        if (ui->tableWidget->hasFocus() && ui->tableWidget->currentRow() >= 0) {
-            ui->tableWidget->removeRow(ui->tableWidget->currentRow());
-            updateComboBox();
-            updateListView();
-            updateArraySize();
-        } else if (ui->listWidget->hasFocus() && ui->listWidget->currentRow() >= 0) {
-            delete ui->listWidget->takeItem(ui->listWidget->currentRow());
+        if (ui->tableView->hasFocus() && ui->tableView->currentIndex().isValid()) {
+            removeSelectedRows();
+        } else if (ui->textListView->hasFocus()) {
+            on_removeListButton_clicked();
         }
     }
     QMainWindow::keyPressEvent(event);
 }
 
-void MainWindow::loadDataFromFile(const QString &filename)
+void MainWindow::loadDataFromFiles(const QStringList &filenames)
 {
-    QFile file(filename);
-    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-        QMessageBox::warning(this, "Ошибка", "Не удалось открыть файл");
+    if (importWatcher->isRunning()) {
         return;
     }
 
-    ui->tableWidget->setRowCount(0);
-    QTextStream in(&file);
-    while (!in.atEnd()) {
-        QString line = in.readLine();
-        QStringList parts = line.split(",");
-        if (parts.size() == 3) {
-            int row = ui->tableWidget->rowCount();
-            ui->tableWidget->insertRow(row);
-            ui->tableWidget->setItem(row, 0, new QTableWidgetItem(parts[0]));
-            ui->tableWidget->setItem(row, 1, new QTableWidgetItem(parts[1]));
-            ui->tableWidget->setItem(row, 2, new QTableWidgetItem(parts[2]));
-        }
+    ui->loadButton->setEnabled(false);
+    ui->statusbar->showMessage(QString("Загрузка файлов: %1").arg(filenames.size()));
+    importTimer.start();
+    importStart = PerfMonitor::shared().now();
+    importFilenames = filenames;
+    importWatcher->setFuture(QtConcurrent::run(&CallRecordImporter::importFiles, filenames));
+}
+
+void MainWindow::finishImport()
+{
+    ui->loadButton->setEnabled(true);
+    CallRecordImporter::Result result = importWatcher->result();
+    PerfMonitor &monitor = PerfMonitor::shared();
+    monitor.record("load", importStart, monitor.now() - importStart, result.records.size());
+    if (!result.errors.isEmpty()) {
+        QMessageBox::warning(this, "Ошибка", QString("Не удалось открыть файл\n%1").arg(result.errors.join("\n")));
     }
-    file.close();
+
+    callModel->setColumns(result.records);
     updateComboBox();
     updateListView();
     updateArraySize();
+    ui->statusbar->showMessage(QString("Загружено записей: %1, повторов удалено: %2, отклонено: %3 (%4, %5 мс)")
+                                   .arg(result.records.size())
+                                   .arg(result.duplicates)
+                                   .arg(result.rejects.total())
+                                   .arg(result.merged ? "слияние" : "склейка")
+                                   .arg(importTimer.elapsed()), 5000);
+    showRejects(result.rejects, importFilenames);
 }
 
 void MainWindow::saveDataToFile(const QString &filename)
 {
-    QFile file(filename);
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
-        QMessageBox::warning(this, "Ошибка", "Не удалось открыть файл для записи");
+    if (saveWatcher->isRunning()) {
         return;
     }
 
-    QTextStream out(&file);
-    for (int i = 0; i < ui->tableWidget->rowCount(); ++i) {
-        QString lastName = ui->tableWidget->item(i, 0)->text();
-        QString time = ui->tableWidget->item(i, 1)->text();
-        QString ip = ui->tableWidget->item(i, 2)->text();
-        out << lastName << "," << time << "," << ip << "\n";
+    // Снимок столбцов: правки таблицы во время сохранения в файл не попадут
+    saveFilename = filename;
+    ui->saveButton->setEnabled(false);
+    saveTimer.start();
+    saveWatcher->setFuture(QtConcurrent::run(&CallRecordWriter::save, callModel->columns(), filename));
+}
+
+void MainWindow::showSaveProgress(int rows)
+{
+    const qint64 elapsed = qMax<qint64>(1, saveTimer.elapsed());
+    ui->statusbar->showMessage(QString("Сохранение: %1 из %2 (%3 строк/с)")
+                                   .arg(rows)
+                                   .arg(saveWatcher->progressMaximum())
+                                   .arg(qint64(rows) * 1000 / elapsed));
+}
+
+void MainWindow::finishSave()
+{
+    ui->saveButton->setEnabled(true);
+    const QString error = saveWatcher->result();
+    if (!error.isEmpty()) {
+        ui->statusbar->clearMessage();
+        QMessageBox::warning(this, "Ошибка", QString("Не удалось сохранить файл: %1").arg(error));
+        return;
     }
-    file.close();
+
+    const qint64 elapsed = qMax<qint64>(1, saveTimer.elapsed());
+    const double megabytes = QFileInfo(saveFilename).size() / (1024.0 * 1024.0);
+    ui->statusbar->showMessage(QString("Сохранено %1 записей за %2 мс (%3 МБ/с)")
+                                   .arg(saveWatcher->progressMaximum())
+                                   .arg(elapsed)
+                                   .arg(megabytes * 1000.0 / elapsed, 0, 'f', 1), 5000);
 }
 
 void MainWindow::updateComboBox()
 {
-    QStringList items;
-    for (int i = 0; i < ui->tableWidget->rowCount(); ++i) {
-        items << ui->tableWidget->item(i, 0)->text();
-    }
-    comboModel->setStringList(items);
+    PerfMonitor::Scope scope("refresh.combo", callModel->recordCount());
+    comboModel->refresh();
 }
 
 void MainWindow::updateListView()
 {
-    QStringListModel *model = new QStringListModel(this);
-    QStringList items;
-    for (int i = 0; i < ui->tableWidget->rowCount(); ++i) {
-        items << QString("%1 - %2 мин - %3")
-                     .arg(ui->tableWidget->item(i, 0)->text())
-                     .arg(ui->tableWidget->item(i, 1)->text())
-                     .arg(ui->tableWidget->item(i, 2)->text());
-    }
-    model->setStringList(items);
-    ui->listView->setModel(model);
+    PerfMonitor::Scope scope("refresh.list", callModel->recordCount());
+    summaryModel->refresh();
 }
 
 void MainWindow::displayImage(const QString &filename)
 {
-    QPixmap pixmap(filename);
-    if (!pixmap.isNull()) {
-        ui->imageLabel->setPixmap(pixmap.scaled(ui->imageLabel->size(), Qt::KeepAspectRatio));
+    imagePath = filename;
+    imageLoader->load(filename, imageTargetSize());
+}
+
+void MainWindow::showImage(const QString &path, const QImage &image)
+{
+    if (path != imagePath)
+        return;
+    this->image = image;
+    updateImageLabel();
+}
+
+QSize MainWindow::imageTargetSize() const
+{
+    return ui->imageLabel->size() * ui->imageLabel->devicePixelRatioF();
+}
+
+void MainWindow::updateImageLabel()
+{
+    if (image.isNull())
+        return;
+
+    QPixmap pixmap = QPixmap::fromImage(image.scaled(imageTargetSize(), Qt::KeepAspectRatio, Qt::SmoothTransformation));
+    pixmap.setDevicePixelRatio(ui->imageLabel->devicePixelRatioF());
+    ui->imageLabel->setPixmap(pixmap);
+}
+
+bool MainWindow::eventFilter(QObject *watched, QEvent *event)
+{
+    // При изменении размера копия из кэша сразу приходит в showImage; если
+    // метка стала заметно больше неё, до окончания декодирования
+    // масштабируется текущая картинка
+    if (watched == ui->imageLabel && event->type() == QEvent::Resize) {
+        if (imagePath.isEmpty() || !imageLoader->load(imagePath, imageTargetSize()))
+            updateImageLabel();
+    }
+    return QMainWindow::eventFilter(watched, event);
+}
+
+void MainWindow::on_aggregateButton_clicked()
+{
+    if (aggregateWatcher->isRunning())
+        return;
+
+    // Снимок столбцов разделяет данные с моделью и не копирует их
+    const CallRecordColumns columns = callModel->columns();
+    const auto groupBy = CallAggregator::GroupBy(ui->groupByComboBox->currentData().toInt());
+    const int prefixLength = ui->prefixSpinBox->value();
+
+    ui->aggregateButton->setEnabled(false);
+    aggregateTimer.start();
+    aggregateWatcher->setFuture(QtConcurrent::run([columns, groupBy, prefixLength]() {
+        return CallAggregator::aggregate(columns, groupBy, prefixLength);
+    }));
+}
+
+void MainWindow::showAggregateResult()
+{
+    const QList<CallAggregator::Group> groups = aggregateWatcher->result();
+    aggregateModel->setGroups(groups);
+    ui->aggregateButton->setEnabled(true);
+    ui->statusbar->showMessage(QString("Групп: %1, %2 мс").arg(groups.size()).arg(aggregateTimer.elapsed()), 5000);
+}
+
+void MainWindow::on_subnetFilterEdit_textChanged(const QString &text)
+{
+    PerfMonitor::Scope scope("filter", callModel->recordCount());
+    quint32 first = 0;
+    quint32 last = 0;
+    if (IpPrefixIndex::parseQuery(text, &first, &last)) {
+        ui->subnetFilterEdit->setStyleSheet(QString());
+        callModel->setIpFilter(first, last);
     } else {
-        QMessageBox::warning(this, "Ошибка", "Не удалось загрузить изображение");
+        // Пока запрос не разобран, показываем все записи
+        ui->subnetFilterEdit->setStyleSheet(text.trimmed().isEmpty() ? QString() : "color: red");
+        callModel->clearIpFilter();
+    }
+    updateArraySize();
+}
+
+void MainWindow::on_searchEdit_textChanged(const QString &text)
+{
+    PerfMonitor::Scope scope("search", callModel->recordCount());
+    if (text.trimmed().isEmpty()) {
+        callModel->clearSurnameFilter();
+    } else {
+        const auto mode = ui->prefixSearchCheckBox->isChecked() ? SurnameIndex::PrefixMatch : SurnameIndex::SubstringMatch;
+        callModel->setSurnameFilter(text, mode);
+    }
+    updateArraySize();
+}
+
+void MainWindow::on_prefixSearchCheckBox_toggled(bool checked)
+{
+    Q_UNUSED(checked);
+    on_searchEdit_textChanged(ui->searchEdit->text());
+}
+
+void MainWindow::on_followButton_toggled(bool checked)
+{
+    if (!checked) {
+        const QString path = logFollower->path();
+        logFollower->stop();
+        showRejects(logFollower->rejects(), {path});
+        return;
+    }
+
+    QString filename = QFileDialog::getOpenFileName(this, "Следить за файлом", "", "Text files (*.txt *.csv)");
+    if (filename.isEmpty()) {
+        ui->followButton->setChecked(false);
+        return;
+    }
+
+    callModel->setColumns(CallRecordColumns());
+    logFollower->start(filename);
+    updateComboBox();
+    updateListView();
+    updateArraySize();
+}
+
+void MainWindow::appendFollowedRecords(const CallRecordColumns &records)
+{
+    callModel->appendRecords(records);
+    // Пачки приходят несколько раз в секунду: сброс моделей терял бы
+    // прокрутку и выбор в списках
+    {
+        PerfMonitor::Scope scope("refresh.combo", records.size());
+        comboModel->appendRows();
+    }
+    {
+        PerfMonitor::Scope scope("refresh.list", records.size());
+        summaryModel->appendRows();
+    }
+    updateArraySize();
+}
+
+void MainWindow::updateStatistics()
+{
+    const DurationStats &stats = callModel->statistics();
+    QString text = QString("Звонков: %1, среднее: %2 мин, p50: %3, p95: %4, p99: %5 мин")
+                       .arg(stats.count())
+                       .arg(stats.count() > 0 ? double(stats.sum()) / double(stats.count()) : 0.0, 0, 'f', 1)
+                       .arg(stats.quantile(0.50))
+                       .arg(stats.quantile(0.95))
+                       .arg(stats.quantile(0.99));
+
+    qint64 largest = 1;
+    for (int bucket = 0; bucket < DurationStats::HistogramBuckets; ++bucket) {
+        largest = qMax(largest, stats.histogramCount(bucket));
+    }
+    for (int bucket = 0; bucket < DurationStats::HistogramBuckets; ++bucket) {
+        const qint64 count = stats.histogramCount(bucket);
+        text += QString("\n%1 %2 %3")
+                    .arg(DurationStats::histogramLabel(bucket), 8)
+                    .arg(QString(int(count * 40 / largest), QChar(0x2588)), -40)
+                    .arg(count);
+    }
+    ui->statsLabel->setText(text);
+}
+
+void MainWindow::on_actionPerfPanel_toggled(bool checked)
+{
+    PerfMonitor::shared().setEnabled(checked);
+    perfLabel->setVisible(checked);
+    if (checked) {
+        updatePerfPanel();
+        perfTimer->start();
+    } else {
+        perfTimer->stop();
+    }
+}
+
+void MainWindow::on_actionSaveTrace_triggered()
+{
+    QString filename = QFileDialog::getSaveFileName(this, "Сохранить трассировку", "trace.json",
+                                                    "Chrome trace (*.json)");
+    if (filename.isEmpty()) {
+        return;
+    }
+    const QString error = PerfMonitor::shared().writeChromeTrace(filename);
+    if (!error.isEmpty()) {
+        QMessageBox::warning(this, "Ошибка", QString("Не удалось сохранить трассировку\n%1").arg(error));
+    }
+}
+
+void MainWindow::updatePerfPanel()
+{
+    const PerfMonitor &monitor = PerfMonitor::shared();
+    const PerfMonitor::Event last = monitor.lastOperation();
+
+    QString text = "Нет замеров";
+    if (last.name) {
+        text = QString("%1: %2 мс").arg(QString::fromLatin1(last.name)).arg(double(last.duration) / 1e6, 0, 'f', 1);
+        if (last.rows > 0 && last.duration > 0)
+            text += QString(", %1 строк/с").arg(qint64(double(last.rows) * 1e9 / double(last.duration)));
     }
+    text += QString(" | RSS %1 МБ, модель %2 МБ | задержки > 16 мс: %3, макс. %4 мс")
+                .arg(PerfMonitor::residentMemory() / (1024 * 1024))
+                .arg(double(callModel->memoryUsage()) / (1024 * 1024), 0, 'f', 1)
+                .arg(monitor.stallCount())
+                .arg(monitor.longestStall());
+    perfLabel->setText(text);
 }
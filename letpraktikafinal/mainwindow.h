@@ -2,13 +2,25 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
-#include <QTableWidget>
-#include <QListWidget>
+#include <QTableView>
 #include <QComboBox>
 #include <QListView>
 #include <QMenu>
 #include <QStringListModel>
 #include <QLabel>
+#include <QFutureWatcher>
+#include <QElapsedTimer>
+#include "callrecordmodel.h"
+#include "callsummarymodel.h"
+#include "surnamelistmodel.h"
+#include "textlistmodel.h"
+#include "callaggregator.h"
+#include "aggregateresultmodel.h"
+#include "imageloader.h"
+#include "callrecordwriter.h"
+#include "calllogfollower.h"
+#include "callrecordimporter.h"
+#include "perfmonitor.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -33,24 +45,70 @@ private slots:
     void on_saveButton_clicked();
     void on_loadButton_clicked();
     void on_loadFromTextButton_clicked();
+    void on_aggregateButton_clicked();
+    void on_subnetFilterEdit_textChanged(const QString &text);
+    void on_searchEdit_textChanged(const QString &text);
+    void on_prefixSearchCheckBox_toggled(bool checked);
+    void on_followButton_toggled(bool checked);
+    void on_actionPerfPanel_toggled(bool checked);
+    void on_actionSaveTrace_triggered();
 
     void handleRightClick(const QPoint &pos);
     void handleTableRightClick(const QPoint &pos);
 
     void keyPressEvent(QKeyEvent *event) override;
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+    void showImage(const QString &path, const QImage &image);
+    void showSaveProgress(int rows);
+    void finishSave();
+    void appendFollowedRecords(const CallRecordColumns &records);
+    void finishImport();
+    void updateStatistics();
+    void updatePerfPanel();
+    void applyListOrder();
 
 private:
     Ui::MainWindow *ui;
     QMenu *contextMenu;
     QMenu *tableContextMenu;
-    QStringListModel *comboModel;
+    SurnameListModel *comboModel;
+    CallSummaryModel *summaryModel;
     QLabel *arraySizeLabel;
+    QLabel *indexSizeLabel;
+    CallRecordModel *callModel;
+    AggregateResultModel *aggregateModel;
+    QFutureWatcher<QList<CallAggregator::Group>> *aggregateWatcher;
+    QElapsedTimer aggregateTimer;
+    ImageLoader *imageLoader;
+    QString imagePath;
+    QImage image;
+    QFutureWatcher<QString> *saveWatcher;
+    QElapsedTimer saveTimer;
+    QString saveFilename;
+    CallLogFollower *logFollower;
+    QFutureWatcher<CallRecordImporter::Result> *importWatcher;
+    QElapsedTimer importTimer;
+    QStringList importFilenames;
+    qint64 importStart = 0;
+    QLabel *perfLabel;
+    QTimer *perfTimer;
+    TextListModel *textListModel;
+    QFutureWatcher<QList<int>> *listSortWatcher;
+    quint64 listSortRevision = 0;
+    qint64 listSortStart = 0;
 
-    void loadDataFromFile(const QString &filename);
+    void loadDataFromFiles(const QStringList &filenames);
     void saveDataToFile(const QString &filename);
+    void removeSelectedRows();
+    void sortTextList(TextListModel::SortKey key);
+    void showRejects(const CallRecordRejects &rejects, const QStringList &sources);
     void updateComboBox();
     void updateListView();
     void displayImage(const QString &filename);
+    void updateImageLabel();
+    QSize imageTargetSize() const;
     void updateArraySize();
+    void showAggregateResult();
 };
 #endif // MAINWINDOW_H
@@ -0,0 +1,187 @@
+#include "perfmonitor.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+#include <algorithm>
+
+#if defined(Q_OS_MACOS)
+#include <mach/mach.h>
+#elif defined(Q_OS_UNIX)
+#include <unistd.h>
+#endif
+
+namespace {
+
+// Замеры интерфейса отличаются от фоновых по имени "stall"
+const char *const StallName = "stall";
+
+}
+
+PerfMonitor::Scope::Scope(const char *name, qint64 rows)
+    : name(name)
+    , rows(rows)
+    , start(-1)
+{
+    if (PerfMonitor::shared().isEnabled())
+        start = PerfMonitor::shared().now();
+}
+
+PerfMonitor::Scope::~Scope()
+{
+    if (start < 0)
+        return;
+    PerfMonitor &monitor = PerfMonitor::shared();
+    monitor.record(name, start, monitor.now() - start, rows);
+}
+
+PerfMonitor &PerfMonitor::shared()
+{
+    // Не удаляется: замеры могут прийти из потоков пула уже после QApplication
+    static PerfMonitor *monitor = new PerfMonitor;
+    return *monitor;
+}
+
+PerfMonitor::PerfMonitor(QObject *parent)
+    : QObject(parent)
+{
+    clock.start();
+    probe = new QTimer(this);
+    probe->setTimerType(Qt::PreciseTimer);
+    probe->setInterval(ProbeInterval);
+    connect(probe, &QTimer::timeout, this, &PerfMonitor::checkStall);
+
+    // Первый замер может случиться в рабочем потоке, а таймер нужен в главном
+    if (QCoreApplication *application = QCoreApplication::instance())
+        moveToThread(application->thread());
+}
+
+void PerfMonitor::setEnabled(bool on)
+{
+    enabled.store(on, std::memory_order_relaxed);
+    // Таймер-зонд живёт в главном потоке: если его срабатывание опоздало,
+    // значит цикл событий был занят и интерфейс не перерисовывался
+    if (on) {
+        lastProbe = now();
+        probe->start();
+    } else {
+        probe->stop();
+    }
+}
+
+void PerfMonitor::checkStall()
+{
+    const qint64 time = now();
+    const qint64 late = (time - lastProbe) / 1000000 - ProbeInterval;
+    if (late > StallThreshold) {
+        {
+            QMutexLocker locker(&mutex);
+            ++stalls;
+            maxStall = qMax(maxStall, late);
+        }
+        record(StallName, lastProbe + qint64(ProbeInterval) * 1000000, late * 1000000);
+    }
+    lastProbe = time;
+}
+
+void PerfMonitor::record(const char *name, qint64 start, qint64 duration, qint64 rows)
+{
+    if (!isEnabled())
+        return;
+
+    const Event event {name, start, duration, rows, quint64(quintptr(QThread::currentThreadId()))};
+    {
+        QMutexLocker locker(&mutex);
+        // Кольцевой буфер: в трассу попадают последние MaxEvents событий
+        if (events.size() < MaxEvents)
+            events.append(event);
+        else
+            events[nextEvent] = event;
+        nextEvent = (nextEvent + 1) % MaxEvents;
+        if (name != StallName)
+            last = event;
+    }
+}
+
+PerfMonitor::Event PerfMonitor::lastOperation() const
+{
+    QMutexLocker locker(&mutex);
+    return last;
+}
+
+int PerfMonitor::stallCount() const
+{
+    QMutexLocker locker(&mutex);
+    return stalls;
+}
+
+qint64 PerfMonitor::longestStall() const
+{
+    QMutexLocker locker(&mutex);
+    return maxStall;
+}
+
+QString PerfMonitor::writeChromeTrace(const QString &filename) const
+{
+    QList<Event> snapshot;
+    {
+        QMutexLocker locker(&mutex);
+        snapshot = events;
+        // Самые старые события в кольце начинаются с nextEvent
+        if (snapshot.size() == MaxEvents)
+            std::rotate(snapshot.begin(), snapshot.begin() + nextEvent, snapshot.end());
+    }
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    QJsonArray traceEvents;
+    for (const Event &event : snapshot) {
+        QJsonObject trace;
+        trace["name"] = QString::fromLatin1(event.name);
+        trace["cat"] = event.name == StallName ? "ui" : "operation";
+        trace["ph"] = "X";
+        trace["ts"] = double(event.start) / 1000.0;
+        trace["dur"] = double(event.duration) / 1000.0;
+        trace["pid"] = double(pid);
+        trace["tid"] = double(event.thread);
+        if (event.rows > 0)
+            trace["args"] = QJsonObject {{"rows", double(event.rows)}};
+        traceEvents.append(trace);
+    }
+
+    QJsonObject root;
+    root["traceEvents"] = traceEvents;
+    root["displayTimeUnit"] = "ms";
+
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly))
+        return file.errorString();
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    if (!file.commit())
+        return file.errorString();
+    return QString();
+}
+
+qint64 PerfMonitor::residentMemory()
+{
+#if defined(Q_OS_MACOS)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, task_info_t(&info), &count) != KERN_SUCCESS)
+        return 0;
+    return qint64(info.resident_size);
+#elif defined(Q_OS_UNIX)
+    QFile statm("/proc/self/statm");
+    if (!statm.open(QIODevice::ReadOnly))
+        return 0;
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    if (fields.size() < 2)
+        return 0;
+    return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE);
+#else
+    return 0;
+#endif
+}
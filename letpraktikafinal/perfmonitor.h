@@ -0,0 +1,80 @@
+#ifndef PERFMONITOR_H
+#define PERFMONITOR_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QTimer>
+#include <atomic>
+
+// Замеры операций для панели производительности и трассировки в формате
+// Chrome trace-event. Пока замеры выключены, Scope стоит одну проверку
+// атомарного флага. Запись возможна из любого потока.
+class PerfMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Event
+    {
+        const char *name;
+        qint64 start;
+        qint64 duration;
+        qint64 rows;
+        quint64 thread;
+    };
+
+    // Замер участка кода от создания до уничтожения; name — строковый литерал
+    class Scope
+    {
+    public:
+        explicit Scope(const char *name, qint64 rows = 0);
+        ~Scope();
+        void setRows(qint64 count) { rows = count; }
+
+    private:
+        const char *name;
+        qint64 rows;
+        qint64 start;
+    };
+
+    static PerfMonitor &shared();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+
+    // Время в наносекундах от запуска программы
+    qint64 now() const { return clock.nsecsElapsed(); }
+    void record(const char *name, qint64 start, qint64 duration, qint64 rows = 0);
+
+    Event lastOperation() const;
+    int stallCount() const;
+    qint64 longestStall() const;
+    QString writeChromeTrace(const QString &filename) const;
+
+    // Резидентная память процесса в байтах (0, если платформа не поддерживается)
+    static qint64 residentMemory();
+
+private:
+    static constexpr int MaxEvents = 100000;
+    static constexpr int StallThreshold = 16;
+    static constexpr int ProbeInterval = 8;
+
+    std::atomic<bool> enabled {false};
+    QElapsedTimer clock;
+    mutable QMutex mutex;
+    QList<Event> events;
+    qsizetype nextEvent = 0;
+    Event last {};
+    int stalls = 0;
+    qint64 maxStall = 0;
+    QTimer *probe;
+    qint64 lastProbe = 0;
+
+    explicit PerfMonitor(QObject *parent = nullptr);
+    void checkStall();
+};
+
+#endif // PERFMONITOR_H
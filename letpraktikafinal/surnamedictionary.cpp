@@ -0,0 +1,153 @@
+#include "surnamedictionary.h"
+#include <QHash>
+#include <algorithm>
+#include <numeric>
+
+SurnameDictionary &SurnameDictionary::shared()
+{
+    static SurnameDictionary dictionary;
+    return dictionary;
+}
+
+quint32 SurnameDictionary::find(QStringView text, quint32 hash) const
+{
+    if (table.isEmpty())
+        return NotFound;
+
+    const qsizetype mask = table.size() - 1;
+    for (qsizetype slot = hash & mask;; slot = (slot + 1) & mask) {
+        const quint32 entry = table.at(slot);
+        if (entry == 0)
+            return NotFound;
+        const Span &span = spans.at(entry - 1);
+        if (span.hash == hash && view(span) == text)
+            return entry - 1;
+    }
+}
+
+void SurnameDictionary::rehash(qsizetype capacity)
+{
+    table = QList<quint32>(capacity, 0);
+    const qsizetype mask = capacity - 1;
+    for (qsizetype id = 0; id < spans.size(); ++id) {
+        qsizetype slot = spans.at(id).hash & mask;
+        while (table.at(slot) != 0)
+            slot = (slot + 1) & mask;
+        table[slot] = quint32(id + 1);
+    }
+}
+
+quint32 SurnameDictionary::intern(QStringView text)
+{
+    const quint32 hash = quint32(qHash(text));
+    {
+        // Почти все фамилии уже есть в словаре: хватает блокировки на чтение
+        QReadLocker locker(&lock);
+        const quint32 id = find(text, hash);
+        if (id != NotFound)
+            return id;
+    }
+
+    QWriteLocker locker(&lock);
+    quint32 id = find(text, hash);
+    if (id != NotFound)
+        return id;
+
+    // Заполнение таблицы не выше половины
+    if ((spans.size() + 1) * 2 > table.size())
+        rehash(qMax<qsizetype>(64, table.size() * 2));
+
+    id = quint32(spans.size());
+    spans.append({quint32(arena.size()), quint32(text.size()), hash});
+    arena.append(text);
+
+    const qsizetype mask = table.size() - 1;
+    qsizetype slot = hash & mask;
+    while (table.at(slot) != 0)
+        slot = (slot + 1) & mask;
+    table[slot] = id + 1;
+    return id;
+}
+
+QString SurnameDictionary::text(quint32 id) const
+{
+    QReadLocker locker(&lock);
+    return id < quint32(spans.size()) ? view(spans.at(id)).toString() : QString();
+}
+
+QList<QByteArray> SurnameDictionary::utf8Texts() const
+{
+    QReadLocker locker(&lock);
+    QList<QByteArray> texts;
+    texts.reserve(spans.size());
+    for (const Span &span : spans)
+        texts.append(view(span).toUtf8());
+    return texts;
+}
+
+QList<quint32> SurnameDictionary::ranks() const
+{
+    QReadLocker locker(&lock);
+    QList<quint32> order(spans.size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [this](quint32 a, quint32 b) {
+        return view(spans.at(a)).compare(view(spans.at(b))) < 0;
+    });
+
+    QList<quint32> ranks(spans.size());
+    for (qsizetype i = 0; i < order.size(); ++i)
+        ranks[order.at(i)] = quint32(i);
+    return ranks;
+}
+
+int SurnameDictionary::size() const
+{
+    QReadLocker locker(&lock);
+    return int(spans.size());
+}
+
+qsizetype SurnameDictionary::memoryUsage() const
+{
+    QReadLocker locker(&lock);
+    return arena.capacity() * qsizetype(sizeof(QChar))
+        + spans.capacity() * qsizetype(sizeof(Span))
+        + table.capacity() * qsizetype(sizeof(quint32));
+}
+
+quint32 SurnameDictionary::Utf8Cache::intern(QByteArrayView utf8)
+{
+    const quint32 hash = quint32(qHash(utf8));
+    if (!table.isEmpty()) {
+        const qsizetype mask = table.size() - 1;
+        for (qsizetype slot = hash & mask; table.at(slot) != 0; slot = (slot + 1) & mask) {
+            const Entry &entry = entries.at(table.at(slot) - 1);
+            if (entry.hash == hash && QByteArrayView(arena).sliced(entry.offset, entry.length) == utf8)
+                return entry.id;
+        }
+    }
+
+    const quint32 id = dictionary.intern(QString::fromUtf8(utf8));
+    if ((entries.size() + 1) * 2 > table.size())
+        rehash(qMax<qsizetype>(64, table.size() * 2));
+    entries.append({quint32(arena.size()), quint32(utf8.size()), hash, id});
+    arena.append(utf8);
+
+    const qsizetype mask = table.size() - 1;
+    qsizetype slot = hash & mask;
+    while (table.at(slot) != 0)
+        slot = (slot + 1) & mask;
+    table[slot] = quint32(entries.size());
+    return id;
+}
+
+void SurnameDictionary::Utf8Cache::rehash(qsizetype capacity)
+{
+    table = QList<quint32>(capacity, 0);
+    const qsizetype mask = capacity - 1;
+    for (qsizetype index = 0; index < entries.size(); ++index) {
+        qsizetype slot = entries.at(index).hash & mask;
+        while (table.at(slot) != 0)
+            slot = (slot + 1) & mask;
+        table[slot] = quint32(index + 1);
+    }
+}
@@ -0,0 +1,80 @@
+#ifndef SURNAMEDICTIONARY_H
+#define SURNAMEDICTIONARY_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QList>
+#include <QReadWriteLock>
+#include <QString>
+#include <QStringView>
+
+// Словарь фамилий: каждая строка хранится один раз в общем буфере, запись
+// таблицы держит только её 32-битный номер. Номера не меняются и не
+// переиспользуются, поэтому равенство фамилий — равенство чисел.
+// Методы потокобезопасны: файлы разбираются в нескольких потоках.
+class SurnameDictionary
+{
+public:
+    // Номера уже встреченных фамилий по их UTF-8 для одного потока, например
+    // на кусок файла: повторная фамилия находится без QString и без
+    // блокировки словаря, к словарю идёт только первая встреча
+    class Utf8Cache
+    {
+    public:
+        explicit Utf8Cache(SurnameDictionary &dictionary = shared()) : dictionary(dictionary) {}
+        quint32 intern(QByteArrayView utf8);
+
+    private:
+        struct Entry
+        {
+            quint32 offset;
+            quint32 length;
+            quint32 hash;
+            quint32 id;
+        };
+
+        SurnameDictionary &dictionary;
+        QByteArray arena;
+        QList<Entry> entries;
+        // Открытая адресация, как в словаре: индекс + 1, ноль — пустая ячейка
+        QList<quint32> table;
+
+        void rehash(qsizetype capacity);
+    };
+
+    static SurnameDictionary &shared();
+
+    quint32 intern(QStringView text);
+    QString text(quint32 id) const;
+    // UTF-8 всех строк, номер — индекс в списке
+    QList<QByteArray> utf8Texts() const;
+    // Место каждой фамилии в порядке QString::compare, индекс — номер.
+    // Снимок на момент вызова: сравнение рангов не трогает словарь и его
+    // блокировку, фамилии, добавленные позже, в снимок не попадают
+    QList<quint32> ranks() const;
+
+    int size() const;
+    qsizetype memoryUsage() const;
+
+private:
+    static constexpr quint32 NotFound = 0xFFFFFFFFu;
+
+    struct Span
+    {
+        quint32 offset;
+        quint32 length;
+        quint32 hash;
+    };
+
+    mutable QReadWriteLock lock;
+    QString arena;
+    QList<Span> spans;
+    // Открытая адресация: номер + 1, ноль — пустая ячейка
+    QList<quint32> table;
+
+    QStringView view(const Span &span) const { return QStringView(arena).sliced(span.offset, span.length); }
+    quint32 find(QStringView text, quint32 hash) const;
+    void rehash(qsizetype capacity);
+};
+
+#endif // SURNAMEDICTIONARY_H
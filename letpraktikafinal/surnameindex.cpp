@@ -0,0 +1,235 @@
+#include "surnameindex.h"
+#include "surnamedictionary.h"
+#include <algorithm>
+#include <iterator>
+#include <queue>
+#include <vector>
+
+namespace {
+
+// Метка начала строки: триграммы с ней отвечают на поиск по префиксу
+constexpr char16_t StartMarker = u'\u0002';
+
+quint64 trigramKey(QStringView text, qsizetype at)
+{
+    return (quint64(text.at(at).unicode()) << 32)
+        | (quint64(text.at(at + 1).unicode()) << 16)
+        | quint64(text.at(at + 2).unicode());
+}
+
+void insertSorted(QList<int> &list, int value)
+{
+    if (list.isEmpty() || list.constLast() < value)
+        list.append(value);
+    else
+        list.insert(std::lower_bound(list.begin(), list.end(), value) - list.begin(), value);
+}
+
+bool eraseSorted(QList<int> &list, int value)
+{
+    const auto it = std::lower_bound(list.begin(), list.end(), value);
+    if (it == list.end() || *it != value)
+        return false;
+    list.erase(it);
+    return true;
+}
+
+}
+
+void SurnameIndex::clear()
+{
+    entries.clear();
+    liveNames = 0;
+    trigrams.clear();
+}
+
+void SurnameIndex::build(const QList<quint32> &surnameIds)
+{
+    clear();
+    for (int row = 0; row < surnameIds.size(); ++row)
+        insert(surnameIds.at(row), row);
+}
+
+QString SurnameIndex::fold(QStringView text)
+{
+    QString folded = text.toString().toCaseFolded();
+    folded.replace(QChar(0x0451), QChar(0x0435)); // ё -> е
+    return folded;
+}
+
+bool SurnameIndex::matches(QStringView foldedName, QStringView foldedQuery, MatchMode mode)
+{
+    return mode == PrefixMatch ? foldedName.startsWith(foldedQuery) : foldedName.contains(foldedQuery);
+}
+
+QList<quint64> SurnameIndex::trigramsOf(QStringView text) const
+{
+    QList<quint64> keys;
+    for (qsizetype i = 0; i + 2 < text.size(); ++i)
+        keys.append(trigramKey(text, i));
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    return keys;
+}
+
+void SurnameIndex::addTrigrams(int id)
+{
+    const QString text = QChar(StartMarker) + entries.at(id).folded;
+    for (quint64 key : trigramsOf(text))
+        insertSorted(trigrams[key], id);
+}
+
+void SurnameIndex::removeTrigrams(int id)
+{
+    const QString text = QChar(StartMarker) + entries.at(id).folded;
+    for (quint64 key : trigramsOf(text)) {
+        auto it = trigrams.find(key);
+        if (it == trigrams.end())
+            continue;
+        eraseSorted(it.value(), id);
+        if (it.value().isEmpty())
+            trigrams.erase(it);
+    }
+}
+
+void SurnameIndex::insert(quint32 id, int row)
+{
+    if (id >= quint32(entries.size()))
+        entries.resize(qsizetype(id) + 1);
+
+    Entry &entry = entries[id];
+    if (entry.rows.isEmpty()) {
+        entry.folded = fold(SurnameDictionary::shared().text(id));
+        addTrigrams(int(id));
+        ++liveNames;
+    }
+    insertSorted(entry.rows, row);
+}
+
+void SurnameIndex::remove(quint32 id, int row)
+{
+    if (id >= quint32(entries.size()))
+        return;
+    if (!eraseSorted(entries[id].rows, row) || !entries.at(id).rows.isEmpty())
+        return;
+
+    removeTrigrams(int(id));
+    entries[id] = Entry();
+    --liveNames;
+}
+
+void SurnameIndex::shiftRows(const QList<int> &removedRows)
+{
+    if (removedRows.isEmpty())
+        return;
+
+    for (Entry &entry : entries) {
+        for (int &row : entry.rows) {
+            if (row > removedRows.constFirst())
+                row -= int(std::lower_bound(removedRows.cbegin(), removedRows.cend(), row) - removedRows.cbegin());
+        }
+    }
+}
+
+QList<int> SurnameIndex::candidates(const QString &foldedQuery, MatchMode mode) const
+{
+    QString text = foldedQuery;
+    if (mode == PrefixMatch)
+        text.prepend(QChar(StartMarker));
+    QList<int> result;
+
+    // Слишком короткий запрос: проверяем все фамилии, их немного
+    if (text.size() < 3) {
+        for (int id = 0; id < entries.size(); ++id) {
+            if (!entries.at(id).rows.isEmpty())
+                result.append(id);
+        }
+        return result;
+    }
+
+    QList<const QList<int> *> postings;
+    for (quint64 key : trigramsOf(text)) {
+        const auto it = trigrams.constFind(key);
+        if (it == trigrams.constEnd())
+            return result;
+        postings.append(&it.value());
+    }
+    std::sort(postings.begin(), postings.end(), [](const QList<int> *a, const QList<int> *b) {
+        return a->size() < b->size();
+    });
+
+    result = *postings.constFirst();
+    for (qsizetype i = 1; i < postings.size() && !result.isEmpty(); ++i) {
+        QList<int> narrowed;
+        std::set_intersection(result.cbegin(), result.cend(),
+                              postings.at(i)->cbegin(), postings.at(i)->cend(),
+                              std::back_inserter(narrowed));
+        result.swap(narrowed);
+    }
+    return result;
+}
+
+QList<int> SurnameIndex::rowsMatching(QStringView query, MatchMode mode) const
+{
+    const QString folded = fold(query.trimmed());
+    QList<int> rows;
+    if (folded.isEmpty())
+        return rows;
+
+    QList<const QList<int> *> matched;
+    qsizetype total = 0;
+    for (int id : candidates(folded, mode)) {
+        const Entry &entry = entries.at(id);
+        if (matches(entry.folded, folded, mode)) {
+            matched.append(&entry.rows);
+            total += entry.rows.size();
+        }
+    }
+    if (matched.size() == 1)
+        return *matched.constFirst();
+
+    // Списки строк уже упорядочены и не пересекаются (у строки одна фамилия):
+    // k-путевое слияние кучей вместо сортировки всех найденных строк
+    struct Cursor
+    {
+        int row;
+        int list;
+        qsizetype next;
+    };
+    const auto greater = [](const Cursor &a, const Cursor &b) { return a.row > b.row; };
+    std::priority_queue<Cursor, std::vector<Cursor>, decltype(greater)> heap(greater);
+    for (int list = 0; list < matched.size(); ++list)
+        heap.push({matched.at(list)->constFirst(), list, 1});
+
+    rows.reserve(total);
+    while (!heap.empty()) {
+        Cursor cursor = heap.top();
+        heap.pop();
+        rows.append(cursor.row);
+        const QList<int> &source = *matched.at(cursor.list);
+        if (cursor.next < source.size()) {
+            cursor.row = source.at(cursor.next++);
+            heap.push(cursor);
+        }
+    }
+    return rows;
+}
+
+bool SurnameIndex::matchesId(quint32 id, QStringView foldedQuery, MatchMode mode) const
+{
+    if (id < quint32(entries.size()) && !entries.at(id).rows.isEmpty())
+        return matches(entries.at(id).folded, foldedQuery, mode);
+    return matches(fold(SurnameDictionary::shared().text(id)), foldedQuery, mode);
+}
+
+qsizetype SurnameIndex::memoryUsage() const
+{
+    // Оценка: сами фамилии лежат в словаре и не учитываются
+    qsizetype bytes = entries.capacity() * qsizetype(sizeof(Entry))
+        + trigrams.capacity() * qsizetype(sizeof(quint64) + sizeof(QList<int>) + sizeof(void *));
+    for (const Entry &entry : entries)
+        bytes += entry.folded.capacity() * qsizetype(sizeof(QChar)) + entry.rows.capacity() * qsizetype(sizeof(int));
+    for (const QList<int> &posting : trigrams)
+        bytes += posting.capacity() * qsizetype(sizeof(int));
+    return bytes;
+}
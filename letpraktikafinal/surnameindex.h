@@ -0,0 +1,56 @@
+#ifndef SURNAMEINDEX_H
+#define SURNAMEINDEX_H
+
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringView>
+
+// Индекс по фамилиям. Для каждого номера из SurnameDictionary хранятся
+// номера строк; по сложенному регистру (ё = е) строятся триграммы, и запрос
+// проверяет только фамилии из пересечения их списков.
+class SurnameIndex
+{
+public:
+    enum MatchMode {
+        PrefixMatch,
+        SubstringMatch
+    };
+
+    void clear();
+    void build(const QList<quint32> &surnameIds);
+
+    void insert(quint32 id, int row);
+    void remove(quint32 id, int row);
+    // removedRows отсортированы и уже удалены из индекса через remove()
+    void shiftRows(const QList<int> &removedRows);
+
+    QList<int> rowsMatching(QStringView query, MatchMode mode) const;
+    // Проверка одной фамилии по уже сложенному запросу
+    bool matchesId(quint32 id, QStringView foldedQuery, MatchMode mode) const;
+
+    int nameCount() const { return liveNames; }
+    qsizetype memoryUsage() const;
+
+    static QString fold(QStringView text);
+    static bool matches(QStringView foldedName, QStringView foldedQuery, MatchMode mode);
+
+private:
+    struct Entry
+    {
+        QString folded;
+        QList<int> rows;
+    };
+
+    // Индекс в списке — номер фамилии в словаре
+    QList<Entry> entries;
+    int liveNames = 0;
+    QHash<quint64, QList<int>> trigrams;
+
+    QList<quint64> trigramsOf(QStringView text) const;
+    void addTrigrams(int id);
+    void removeTrigrams(int id);
+    QList<int> candidates(const QString &foldedQuery, MatchMode mode) const;
+};
+
+#endif // SURNAMEINDEX_H
@@ -0,0 +1,41 @@
+#include "surnamelistmodel.h"
+
+SurnameListModel::SurnameListModel(CallRecordModel *records, QObject *parent)
+    : QAbstractListModel(parent)
+    , records(records)
+{
+    rows = records->recordCount();
+}
+
+int SurnameListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : rows;
+}
+
+QVariant SurnameListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || (role != Qt::DisplayRole && role != Qt::EditRole))
+        return QVariant();
+    return records->columns().lastName(index.row());
+}
+
+void SurnameListModel::refresh()
+{
+    beginResetModel();
+    rows = records->recordCount();
+    endResetModel();
+}
+
+void SurnameListModel::appendRows()
+{
+    const int count = records->recordCount();
+    if (count < rows) {
+        refresh();
+        return;
+    }
+    if (count == rows)
+        return;
+    beginInsertRows(QModelIndex(), rows, count - 1);
+    rows = count;
+    endInsertRows();
+}
@@ -0,0 +1,29 @@
+#ifndef SURNAMELISTMODEL_H
+#define SURNAMELISTMODEL_H
+
+#include <QAbstractListModel>
+#include "callrecordmodel.h"
+
+// Фамилии записей для выпадающего списка: строки не копируются,
+// текст берётся из словаря по номеру при отрисовке
+class SurnameListModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    explicit SurnameListModel(CallRecordModel *records, QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+    void refresh();
+    // Записи дописаны в конец таблицы: добавляются только новые строки,
+    // текущий элемент и прокрутка представления сохраняются
+    void appendRows();
+
+private:
+    CallRecordModel *records;
+    int rows = 0;
+};
+
+#endif // SURNAMELISTMODEL_H
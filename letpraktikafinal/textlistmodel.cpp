@@ -0,0 +1,121 @@
+#include "textlistmodel.h"
+#include <algorithm>
+#include <numeric>
+#include <utility>
+
+TextListModel::TextListModel(QObject *parent)
+    : QAbstractListModel(parent)
+{
+}
+
+int TextListModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(texts.size());
+}
+
+QVariant TextListModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || (role != Qt::DisplayRole && role != Qt::EditRole))
+        return QVariant();
+    return texts.at(index.row());
+}
+
+bool TextListModel::removeRows(int row, int count, const QModelIndex &parent)
+{
+    if (parent.isValid() || row < 0 || count <= 0 || row + count > texts.size())
+        return false;
+
+    beginRemoveRows(QModelIndex(), row, row + count - 1);
+    texts.remove(row, count);
+    ++changes;
+    endRemoveRows();
+    return true;
+}
+
+void TextListModel::sort(int column, Qt::SortOrder order)
+{
+    if (column == 0)
+        sortBy(LexicalKey, order);
+}
+
+void TextListModel::appendItem(const QString &text)
+{
+    const int row = int(texts.size());
+    beginInsertRows(QModelIndex(), row, row);
+    texts.append(text);
+    ++changes;
+    endInsertRows();
+}
+
+QList<int> TextListModel::sortedOrder(const QStringList &texts, SortKey key, Qt::SortOrder order)
+{
+    const int size = int(texts.size());
+    QList<int> result(size);
+    const bool descending = order == Qt::DescendingOrder;
+
+    if (key == LengthKey) {
+        // Длины — небольшие целые: устойчивая сортировка подсчётом за O(n)
+        qsizetype longest = 0;
+        for (const QString &text : texts)
+            longest = qMax(longest, text.size());
+        QList<int> starts(longest + 2, 0);
+        for (const QString &text : texts)
+            ++starts[(descending ? longest - text.size() : text.size()) + 1];
+        std::partial_sum(starts.begin(), starts.end(), starts.begin());
+        for (int row = 0; row < size; ++row) {
+            const qsizetype length = texts.at(row).size();
+            result[starts[descending ? longest - length : length]++] = row;
+        }
+        return result;
+    }
+
+    std::iota(result.begin(), result.end(), 0);
+    std::stable_sort(result.begin(), result.end(), [&texts, descending](int a, int b) {
+        return descending ? texts.at(b) < texts.at(a) : texts.at(a) < texts.at(b);
+    });
+    return result;
+}
+
+void TextListModel::applyOrder(const QList<int> &order)
+{
+    if (order.size() != texts.size())
+        return;
+
+    emit layoutAboutToBeChanged({}, QAbstractItemModel::VerticalSortHint);
+
+    // Новое место каждой прежней строки
+    QList<int> position(order.size());
+    for (int i = 0; i < order.size(); ++i)
+        position[order.at(i)] = i;
+
+    // Перестановка по циклам: каждая строка перемещается один раз, без копий текста
+    QList<bool> placed(order.size(), false);
+    for (int start = 0; start < order.size(); ++start) {
+        if (placed.at(start))
+            continue;
+        QString carried = std::move(texts[start]);
+        int from = start;
+        for (int to = position.at(from); to != start; to = position.at(from)) {
+            std::swap(carried, texts[to]);
+            placed[to] = true;
+            from = to;
+        }
+        texts[start] = std::move(carried);
+        placed[start] = true;
+    }
+    ++changes;
+
+    const QModelIndexList persistent = persistentIndexList();
+    QModelIndexList updated;
+    updated.reserve(persistent.size());
+    for (const QModelIndex &index : persistent)
+        updated.append(this->index(position.at(index.row())));
+    changePersistentIndexList(persistent, updated);
+
+    emit layoutChanged({}, QAbstractItemModel::VerticalSortHint);
+}
+
+void TextListModel::sortBy(SortKey key, Qt::SortOrder order)
+{
+    applyOrder(sortedOrder(texts, key, order));
+}
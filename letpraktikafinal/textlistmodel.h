@@ -0,0 +1,44 @@
+#ifndef TEXTLISTMODEL_H
+#define TEXTLISTMODEL_H
+
+#include <QAbstractListModel>
+#include <QList>
+#include <QStringList>
+
+// Произвольный список строк. Сортировка считает перестановку номеров
+// (это можно делать в фоне по снимку строк), затем переставляет строки
+// на месте по циклам перестановки и сообщает представлениям одним
+// layoutChanged.
+class TextListModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum SortKey {
+        LexicalKey,
+        LengthKey
+    };
+
+    explicit TextListModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    bool removeRows(int row, int count, const QModelIndex &parent = QModelIndex()) override;
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+    void appendItem(const QString &text);
+    const QStringList &items() const { return texts; }
+    // Меняется при каждой правке; по нему видно, устарел ли порядок из фона
+    quint64 revision() const { return changes; }
+
+    // Устойчивый порядок: order[i] — прежний номер строки, которая встанет на место i
+    static QList<int> sortedOrder(const QStringList &texts, SortKey key, Qt::SortOrder order = Qt::AscendingOrder);
+    void applyOrder(const QList<int> &order);
+    void sortBy(SortKey key, Qt::SortOrder order = Qt::AscendingOrder);
+
+private:
+    QStringList texts;
+    quint64 changes = 0;
+};
+
+#endif // TEXTLISTMODEL_H